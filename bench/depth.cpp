@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "../include/Elson.hpp"
+
+/**
+ * Parses a document nested 1000 levels deep and a wide array of
+ * small objects with Parser, FastParser and StreamParser (fed in
+ * 64 KB chunks). Events go to an empty Handler unless a Value is
+ * built.
+ */
+
+using namespace JSON;
+typedef std::chrono::steady_clock Clock;
+
+// Arrays and objects alternating depth levels deep
+std::string nested(size_t depth) {
+    std::string json;
+    for (size_t level = 0; level < depth; level++) {
+        json += level % 2 ? "{\"k\":" : "[";
+    }
+    json += "1";
+    for (size_t level = depth; level-- > 0;) {
+        json += level % 2 ? "}" : "]";
+    }
+    return json;
+}
+
+std::string wide(size_t count) {
+    std::string json = "[";
+    for (size_t index = 0; index < count; index++) {
+        json += index ? "," : "";
+        json += "{\"id\":" + std::to_string(index)
+            + ",\"tags\":[1,2,3],\"name\":\"x\",\"ok\":true}";
+    }
+    return json + "]";
+}
+
+// Best throughput of f on json in MB/s, at least 0.5 seconds of runs
+template <typename F> double throughput(const std::string& json, F f) {
+    double fastest = 1e9;
+    double total = 0;
+    while (total < 0.5) {
+        Clock::time_point start = Clock::now();
+        f();
+        double time = std::chrono::duration<double>(
+            Clock::now() - start).count();
+        fastest = std::min(fastest, time);
+        total += time;
+    }
+    return json.length() / fastest / 1e6;
+}
+
+int main() {
+    std::string documents[] = { nested(1000), wide(100000) };
+    const char* names[] = { "deep 1000", "wide" };
+
+    printf("%-10s %10s %10s %10s %10s  (MB/s)\n", "",
+        "Parser", "to Value", "Fast", "Stream");
+
+    for (int document = 0; document < 2; document++) {
+        const std::string& json = documents[document];
+        Parser parser;
+        FastParser fast;
+        Handler handler;
+
+        double events = throughput(json, [&] {
+            parser.parse(handler, json);
+        });
+        double values = throughput(json, [&] {
+            Value val;
+            parser.parse(val, json);
+        });
+        double indexed = throughput(json, [&] {
+            fast.parse(handler, json);
+        });
+        double streamed = throughput(json, [&] {
+            StreamParser stream(handler);
+            for (size_t offset = 0; offset < json.length();
+                 offset += 65536) {
+                stream.feed(json.data() + offset,
+                    std::min<size_t>(65536, json.length() - offset));
+            }
+            stream.finish();
+        });
+
+        printf("%-10s %10.1f %10.1f %10.1f %10.1f\n", names[document],
+            events, values, indexed, streamed);
+    }
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include "../include/Elson.hpp"
+
+/**
+ * Builds objects key by key through Value::operator[], looks every
+ * key up and prints them. std::map<std::string, Value>, which
+ * JSON::Object used to be, is measured alongside as the reference.
+ */
+
+using namespace JSON;
+typedef std::chrono::steady_clock Clock;
+
+static double seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Best time of repeated runs of f, at least 0.2 seconds in total
+template <typename F> double best(F f) {
+    double fastest = 1e9;
+    double total = 0;
+    int runs = 0;
+    while (total < 0.2 || runs < 3) {
+        Clock::time_point start = Clock::now();
+        f();
+        double time = seconds(start);
+        fastest = std::min(fastest, time);
+        total += time;
+        runs++;
+    }
+    return fastest;
+}
+
+int main() {
+    std::mt19937 random(42);
+    size_t sizes[] = { 10, 100, 1000, 10000, 100000 };
+
+    printf("%8s %13s %13s %12s %12s %10s\n", "keys", "insert ms",
+        "map insert", "find M/s", "map find", "print MB/s");
+
+    for (size_t size : sizes) {
+        std::vector<std::string> keys;
+        for (size_t index = 0; index < size; index++) {
+            keys.push_back("key" + std::to_string(random()));
+        }
+        std::shuffle(keys.begin(), keys.end(), random);
+
+        // Enough objects per run to time small sizes
+        size_t repeat = 100000 / size;
+
+        Value val;
+        double insert = best([&] {
+            for (size_t round = 0; round < repeat; round++) {
+                val = Object();
+                for (size_t index = 0; index < size; index++) {
+                    val[keys[index]] = (int) index;
+                }
+            }
+        }) / repeat;
+
+        std::map<std::string, Value> map;
+        double mapInsert = best([&] {
+            for (size_t round = 0; round < repeat; round++) {
+                map.clear();
+                for (size_t index = 0; index < size; index++) {
+                    map[keys[index]] = (int) index;
+                }
+            }
+        }) / repeat;
+
+        size_t found = 0;
+        const Value& lookup = val;
+        double find = best([&] {
+            for (size_t round = 0; round < repeat; round++) {
+                for (const std::string& key : keys) {
+                    found += lookup.find(key) != 0;
+                }
+            }
+        });
+
+        double mapFind = best([&] {
+            for (size_t round = 0; round < repeat; round++) {
+                for (const std::string& key : keys) {
+                    found += map.find(key) != map.end();
+                }
+            }
+        });
+
+        Printer printer;
+        size_t printed = printer.print(val).length();
+        double print = best([&] {
+            for (size_t round = 0; round < repeat; round++) {
+                found += printer.print(val).length();
+            }
+        });
+
+        double lookups = (double) size * repeat / 1e6;
+        printf("%8zu %13.3f %13.3f %12.1f %12.1f %10.1f\n", size,
+            insert * 1e3, mapInsert * 1e3, lookups / find,
+            lookups / mapFind, printed * repeat / print / 1e6);
+        if (found == 0) {
+            return 1;
+        }
+    }
+}
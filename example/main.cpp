@@ -1,21 +1,24 @@
 #include <iostream>
 #include "../include/Elson.hpp"
 
-int main () {
+int main (int argc, char* argv[]) {
     using namespace JSON;
     Value val;
-    Parser parser;
     PrettyPrinter printer;
-  
-    std::string json_source;
-    for (std::string line; std::getline(std::cin, line);) {
-        json_source += line;
-        // Insert newlines to allow the parser to
-        // print the line number of an eventual
-        // error
-        json_source += '\n';
+
+    if (argc > 1) {
+        // Files are mapped and parsed in place
+        Parser parser;
+        parser.parseFile(val, argv[1]);
+    } else {
+        // Parse stdin as it arrives instead of collecting it first
+        StreamParser parser(val);
+        char buffer[4096];
+        while (std::cin.read(buffer, sizeof(buffer)) || std::cin.gcount()) {
+            parser.feed(buffer, std::cin.gcount());
+        }
+        parser.finish();
     }
-    
-    parser.parse(val, json_source);        
+
     std::cout << printer.print(val) << std::endl;
 }
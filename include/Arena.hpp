@@ -0,0 +1,143 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <new>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "Exceptions.hpp"
+#include "MemoryResource.hpp"
+
+namespace JSON {
+    /**
+     * Monotonic allocator: memory is handed out front to back from
+     * large blocks and only returned as a whole by reset() or the
+     * destructor. Freeing single allocations is a no-op.
+     */
+    class Arena : public MemoryResource {
+        public:
+            Arena(size_t blockSize = 64 * 1024)
+            : blockSize(blockSize ? blockSize : 1), blocks(0),
+              current(0), end(0) { }
+
+            ~Arena() {
+                release();
+            }
+
+            void * allocate(size_t size, size_t alignment);
+
+            void deallocate(void *, size_t, size_t) { }
+
+            bool isMonotonic() const {
+                return true;
+            }
+
+            // Make all memory available again. Blocks are kept (and
+            // merged into one) so that reuse does not allocate.
+            void reset();
+
+            // Return all blocks to the system
+            void release();
+
+            // Bytes handed out (including the unused ends of older
+            // blocks) and available in total
+            size_t used() const;
+            size_t capacity() const;
+
+        private:
+            Arena(const Arena&);
+            Arena& operator=(const Arena&);
+
+            // Blocks form a list, newest first
+            struct Block {
+                Block * next;
+                size_t size;
+            };
+
+            static char * data(Block * block) {
+                return (char*) block + sizeof(Block);
+            }
+
+            void addBlock(size_t size);
+
+            size_t blockSize;
+            Block * blocks;
+
+            // Free space in the newest block
+            char * current;
+            char * end;
+    };
+
+    void * Arena::allocate(size_t size, size_t alignment) {
+        size_t padding = (alignment - (size_t) current % alignment) % alignment;
+        if (!blocks || (size_t) (end - current) < size + padding) {
+            addBlock(size + alignment);
+            padding = (alignment - (size_t) current % alignment) % alignment;
+        }
+
+        void * memory = current + padding;
+        current += padding + size;
+        return memory;
+    }
+
+    void Arena::addBlock(size_t size) {
+        // Grow geometrically to keep the number of blocks small
+        size_t next = blocks ? blocks->size * 2 : blockSize;
+        if (next < size) {
+            next = size;
+        }
+
+        Block * block = (Block*) malloc(sizeof(Block) + next);
+        if (!block) {
+            ELSON_THROW(std::bad_alloc());
+        }
+        block->next = blocks;
+        block->size = next;
+        blocks = block;
+
+        current = data(block);
+        end = current + next;
+    }
+
+    void Arena::reset() {
+        if (blocks && blocks->next) {
+            // Replace the list by a single block large enough for
+            // everything that was allocated
+            size_t total = capacity();
+            release();
+            addBlock(total);
+        } else if (blocks) {
+            current = data(blocks);
+        }
+    }
+
+    void Arena::release() {
+        while (blocks) {
+            Block * next = blocks->next;
+            free(blocks);
+            blocks = next;
+        }
+        current = end = 0;
+    }
+
+    size_t Arena::used() const {
+        if (!blocks) {
+            return 0;
+        }
+        size_t total = current - data(blocks);
+        for (Block * block = blocks->next; block; block = block->next) {
+            total += block->size;
+        }
+        return total;
+    }
+
+    size_t Arena::capacity() const {
+        size_t total = 0;
+        for (Block * block = blocks; block; block = block->next) {
+            total += block->size;
+        }
+        return total;
+    }
+}
+
+#endif // ARENA_H
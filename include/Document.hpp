@@ -0,0 +1,66 @@
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include "Arena.hpp"
+#include "KeyTable.hpp"
+#include "Value.hpp"
+
+namespace JSON {
+    /**
+     * A Value tree whose strings and containers all live in an arena
+     * owned by the document. Nothing is freed node by node: reset()
+     * and destruction release the whole tree at once, and a document
+     * that is reset and reused does not allocate once its arena is
+     * large enough.
+     *
+     * Values copied out of a document go to the heap, values put into
+     * it are copied into the arena. Move construction keeps the arena:
+     * a value constructed from std::move(doc.getRoot()) is only valid
+     * until the document is reset or destroyed.
+     *
+     * Object keys parsed into a document are interned (unless
+     * disabled) so that records with the same field names share them.
+     */
+    class Document {
+        public:
+            Document(size_t blockSize = 64 * 1024, bool internKeys = true)
+            : arena(blockSize), keys(&arena), internKeys(internKeys),
+              root(&arena) { }
+
+            Value& getRoot() {
+                return root;
+            }
+
+            const Value& getRoot() const {
+                return root;
+            }
+
+            Arena& getArena() {
+                return arena;
+            }
+
+            // Table for the keys of parsed objects, 0 if disabled
+            KeyTable * getKeyTable() {
+                return internKeys ? &keys : 0;
+            }
+
+            // Drop the tree and keep the memory for the next one
+            void reset() {
+                root = Value();
+                keys.clear();
+                arena.reset();
+            }
+
+        private:
+            Document(const Document&);
+            Document& operator=(const Document&);
+
+            // Declared first so that they outlive the root
+            Arena arena;
+            KeyTable keys;
+            bool internKeys;
+            Value root;
+    };
+}
+
+#endif // DOCUMENT_H
@@ -2,8 +2,12 @@
 #define ELSON_H
 
 #include "./Exceptions.hpp"
+#include "./Document.hpp"
 #include "./Parser.hpp"
+#include "./FastParser.hpp"
+#include "./StreamParser.hpp"
 #include "./PrettyPrinter.hpp"
+#include "./Writer.hpp"
 #include "./Utils.hpp"
 
 #endif // ELSON_H
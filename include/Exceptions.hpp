@@ -5,6 +5,22 @@
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+
+// Without exception support (-fno-exceptions) errors that would be
+// thrown abort instead. Define ELSON_THROW to handle them differently.
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#   define ELSON_EXCEPTIONS
+#endif
+
+#ifndef ELSON_THROW
+#   ifdef ELSON_EXCEPTIONS
+#       define ELSON_THROW(exception) throw exception
+#   else
+#       define ELSON_THROW(exception) abort()
+#   endif
+#endif
 
 namespace JSON {
       // Possible JSON types
@@ -27,6 +43,47 @@ namespace JSON {
         {JSON_NULL,   "null"}
     };
 
+    // Why a document could not be parsed
+    enum ParseErrorCode {
+        PARSE_OK = 0,
+        PARSE_SYNTAX_ERROR,
+        PARSE_UNEXPECTED_END,
+        PARSE_UNEXPECTED_CHARACTERS,
+        PARSE_INVALID_CODE_POINT,
+        PARSE_TOO_DEEP
+    };
+
+    /*
+     * Outcome of Parser::tryParse, also carried by the exceptions for
+     * invalid input. Filled in without throwing or allocating. Like
+     * std::error_code it converts to true if there is an error.
+     */
+    struct ParseError {
+        ParseError()
+        : code(PARSE_OK), offset(0), line(0), column(0) { }
+
+        ParseErrorCode code;
+        size_t offset;          // of the offending byte in the input
+        size_t line;            // one based
+        size_t column;          // one based, in bytes
+
+        explicit operator bool() const {
+            return code != PARSE_OK;
+        }
+
+        const char * message() const {
+            switch (code) {
+            case PARSE_OK:                      return "No error";
+            case PARSE_SYNTAX_ERROR:            return "Syntax error";
+            case PARSE_UNEXPECTED_END:          return "Unexpected end of input";
+            case PARSE_UNEXPECTED_CHARACTERS:
+                return "Unexpected characters at end of input";
+            case PARSE_TOO_DEEP:                return "Nesting too deep";
+            default:                            return "Invalid code point";
+            }
+        }
+    };
+
     /*
      * Occurs when trying to convert a value to a type
      * for which no conversion is known.
@@ -49,47 +106,140 @@ namespace JSON {
     };
     
     /*
-     * Exception for unexpected end of parse input
+     * Base of the exceptions for invalid input. Tells where the
+     * parser found the error (line and column are 0 if unknown).
      */
-    class UnexpectedEndOfInputException : public std::runtime_error {
+    class InputException : public std::runtime_error {
     public:
-        UnexpectedEndOfInputException(int line) 
-        : std::runtime_error("") {
+        ParseErrorCode code() const {
+            return position.code;
+        }
+
+        // Byte offset of the offending byte in the input
+        size_t offset() const {
+            return position.offset;
+        }
+
+        size_t line() const {
+            return position.line;
+        }
+
+        size_t column() const {
+            return position.column;
+        }
+
+    protected:
+        InputException(ParseErrorCode code, const ParseError& at)
+        : std::runtime_error(""), position(at) {
+            position.code = code;
+        }
+
+        // Message followed by the position
+        void describe(const char * message) {
             std::stringstream ss;
-            ss << "Unexpected end of input in line " << line;
-            static_cast<std::runtime_error&>(*this) = 
+            ss << message;
+            if (position.line > 0) {
+                ss << " in line " << position.line
+                   << ", column " << position.column;
+            }
+            static_cast<std::runtime_error&>(*this) =
               std::runtime_error(ss.str());
         }
+
+    private:
+        ParseError position;
+    };
+
+    /*
+     * Exception for unexpected end of parse input
+     */
+    class UnexpectedEndOfInputException : public InputException {
+    public:
+        UnexpectedEndOfInputException(const ParseError& at)
+        : InputException(PARSE_UNEXPECTED_END, at) {
+            describe("Unexpected end of input");
+        }
     };    
 
     /*
      * Parsing terminated but still data in the stream
      */
-    class UnexpectedCharactersException : public std::runtime_error {
+    class UnexpectedCharactersException : public InputException {
     public:
-        UnexpectedCharactersException()
-        : std::runtime_error("Unexpected characters at end of input") { }
+        UnexpectedCharactersException(const ParseError& at)
+        : InputException(PARSE_UNEXPECTED_CHARACTERS, at) {
+            static_cast<std::runtime_error&>(*this) =
+              std::runtime_error("Unexpected characters at end of input");
+        }
     };    
     
     /*
      * JSON syntax error
      */
-    class ParseException : public std::runtime_error {
+    class ParseException : public InputException {
     public:
-        ParseException(int line)
+        ParseException(const ParseError& at)
+        : InputException(PARSE_SYNTAX_ERROR, at) {
+            describe("Syntax error");
+        }
+    };
+    
+    /*
+     * More nested arrays and objects than the parser accepts
+     */
+    class NestingDepthException : public InputException {
+    public:
+        NestingDepthException(size_t maxDepth, const ParseError& at)
+        : InputException(PARSE_TOO_DEEP, at) {
+            std::stringstream ss;
+            ss << "Nesting deeper than " << maxDepth;
+            describe(ss.str().c_str());
+        }
+    };
+
+    /*
+     * A file could not be opened or read
+     */
+    class FileException : public std::runtime_error {
+    public:
+        FileException(const std::string& path, int error)
         : std::runtime_error("") {
             std::stringstream ss;
-            ss << "Syntax error in line " << line;
+            ss << "Could not read '" << path << "': " << strerror(error);
             static_cast<std::runtime_error&>(*this) = 
               std::runtime_error(ss.str());
         }
     };
-    
-        // Invalid code point in utf8 sequence.
-    class InvalidCodePointException : public std::runtime_error {
+
+    /*
+     * Output could not be written
+     */
+    class WriteException : public std::runtime_error {
     public:
-        InvalidCodePointException(int codePoint)
+        WriteException(int error)
         : std::runtime_error("") {
+            std::stringstream ss;
+            ss << "Could not write output: " << strerror(error);
+            static_cast<std::runtime_error&>(*this) = 
+              std::runtime_error(ss.str());
+        }
+    };
+
+    /*
+     * Writer calls that do not form a well formed document
+     */
+    class WriterException : public std::logic_error {
+    public:
+        WriterException(const std::string& message)
+        : std::logic_error("Invalid JSON writer call: " + message) { }
+    };
+
+        // Invalid code point in utf8 sequence.
+    class InvalidCodePointException : public InputException {
+    public:
+        InvalidCodePointException(int codePoint,
+            const ParseError& at = ParseError())
+        : InputException(PARSE_INVALID_CODE_POINT, at) {
             std::stringstream ss;
             ss << "Invalid code point " << codePoint;
             static_cast<std::runtime_error&>(*this) = 
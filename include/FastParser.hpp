@@ -0,0 +1,473 @@
+#ifndef FASTPARSER_H
+#define FASTPARSER_H
+
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+#include "Parser.hpp"
+
+namespace JSON {
+    /**
+     * Two stage JSON parser producing the same Values (and
+     * exceptions) as JSON::Parser.
+     *
+     * Stage one classifies the input 64 bytes at a time with SIMD and
+     * records the position of every structural character outside of
+     * strings ({}[]:,), every opening quote and the start of every
+     * other scalar. Stage two walks this index with an explicit stack
+     * and reports the document to a Handler (building a Value by
+     * default). It skips whitespace, but still scans the contents of
+     * each string to copy and unescape it.
+     */
+    class FastParser {
+        public:
+            FastParser()
+            : source(0), length(0), maxDepth(default_max_depth) { }
+
+            // Arrays and objects allowed within each other
+            size_t getMaxDepth() const {
+                return maxDepth;
+            }
+
+            void setMaxDepth(size_t depth) {
+                maxDepth = depth;
+            }
+
+            void parse(Value& object, const std::string& source);
+            void parse(Value& object, const char * source);
+            void parse(Value& object, const char * source, size_t length);
+
+            // Reset the document and parse into its arena
+            void parse(Document& document, const std::string& source);
+            void parse(Document& document, const char * source);
+            void parse(Document& document, const char * source, size_t length);
+
+            // Report the document to a handler instead of building
+            // a Value.
+            void parse(Handler& handler, const std::string& source);
+            void parse(Handler& handler, const char * source);
+            void parse(Handler& handler, const char * source, size_t length);
+
+            // Parse a file through a read-only memory mapping
+            void parseFile(Value& object, const char * path);
+            void parseFile(Handler& handler, const char * path);
+
+        private:
+            // Stage one
+            void buildIndex();
+
+            // Stage two
+            void walkIndex(Handler& handler);
+
+            // Position of the next structural character
+            uint32_t token(size_t index) const {
+                if (index >= structurals.size()) {
+                    ELSON_THROW(UnexpectedEndOfInputException(
+                        locate(PARSE_UNEXPECTED_END, length)));
+                }
+                return structurals[index];
+            }
+
+            // Scalars must be followed by whitespace, an operator
+            // or the end of the input.
+            void requireDelimiter(size_t position) const {
+                if (position < length
+                    && !simd::isWhitespace(source[position])
+                    && !simd::isOperator(source[position])) {
+                    if (containers.empty()) {
+                        ELSON_THROW(UnexpectedCharactersException(
+                            locate(PARSE_UNEXPECTED_CHARACTERS, position)));
+                    }
+                    ELSON_THROW(ParseException(
+                        locate(PARSE_SYNTAX_ERROR, position)));
+                }
+            }
+
+            ParseError locate(ParseErrorCode code, size_t position) const {
+                return locateError(code, source, position);
+            }
+
+            // Before an array or object is opened at position
+            void checkDepth(size_t position) const {
+                if (containers.size() >= maxDepth) {
+                    ELSON_THROW(NestingDepthException(maxDepth,
+                        locate(PARSE_TOO_DEEP, position)));
+                }
+            }
+
+            uint32_t readString(uint32_t position, std::string& buffer);
+            uint32_t readScalar(uint32_t position, Handler& handler);
+            uint32_t readLiteral(uint32_t position, const char* literal,
+                size_t size) const;
+
+            // Input buffer, owned by the caller
+            const char * source;
+            size_t length;
+
+            // Positions of structural characters, reused between
+            // parses
+            std::vector<uint32_t> structurals;
+
+            // Open arrays ('[') and objects ('{')
+            std::vector<char> containers;
+            size_t maxDepth;
+
+            std::string currentProperty;
+            std::string currentString;
+
+            // Builds Values, kept to reuse its buffers
+            ValueBuilder builder;
+    };
+
+    /**
+     * Stage one: structural index
+     */
+    void FastParser::buildIndex() {
+        structurals.clear();
+
+        // Carried over from the previous block
+        uint64_t escapedCarry = 0;
+        uint64_t inStringCarry = 0;
+        uint64_t scalarCarry = 0;
+
+        // The last partial block is padded with whitespace
+        char padded[64];
+
+        for (size_t offset = 0; offset < length; offset += 64) {
+            const char* block = source + offset;
+            if (length - offset < 64) {
+                memset(padded, ' ', sizeof(padded));
+                memcpy(padded, block, length - offset);
+                block = padded;
+            }
+
+            simd::BlockMasks masks;
+            simd::classify(block, masks);
+
+            // Characters escaped by a backslash. Runs of backslashes
+            // are rare so they are resolved one by one.
+            uint64_t escaped = escapedCarry;
+            escapedCarry = 0;
+            for (uint64_t backslash = masks.backslash & ~escaped;
+                 backslash; backslash &= backslash - 1) {
+                int index = simd::firstBit64(backslash);
+                if (escaped & (1ULL << index)) {
+                    continue;
+                }
+                if (index == 63) {
+                    escapedCarry = 1;
+                } else {
+                    escaped |= 1ULL << (index + 1);
+                }
+            }
+
+            // Prefix xor over the unescaped quotes: bits inside of
+            // strings (including the opening quote) are set
+            uint64_t quote = masks.quote & ~escaped;
+            uint64_t inString = quote;
+            inString ^= inString << 1;
+            inString ^= inString << 2;
+            inString ^= inString << 4;
+            inString ^= inString << 8;
+            inString ^= inString << 16;
+            inString ^= inString << 32;
+            inString ^= inStringCarry;
+            inStringCarry = (uint64_t) ((int64_t) inString >> 63);
+
+            // Scalars start after whitespace or an operator
+            uint64_t scalar = ~(masks.op | masks.whitespace);
+            uint64_t nonQuoteScalar = scalar & ~quote;
+            uint64_t followsScalar = (nonQuoteScalar << 1) | scalarCarry;
+            scalarCarry = nonQuoteScalar >> 63;
+            uint64_t scalarStart = scalar & ~followsScalar;
+
+            // Drop everything inside of strings and closing quotes
+            uint64_t stringTail = inString ^ quote;
+            uint64_t bits = (masks.op | scalarStart) & ~stringTail;
+
+            if (offset + 64 > length) {
+                // Ignore the padding
+                bits &= (1ULL << (length - offset)) - 1;
+            }
+
+            for (; bits; bits &= bits - 1) {
+                structurals.push_back(
+                    (uint32_t) (offset + simd::firstBit64(bits)));
+            }
+        }
+    }
+
+    /**
+     * Stage two: walk the index
+     */
+    void FastParser::walkIndex(Handler& handler) {
+        enum State { PARSE_VALUE, PARSE_PROPERTY, PARSE_NEXT };
+
+        containers.clear();
+        State state = PARSE_VALUE;
+        size_t index = 0;
+
+        for (;;) {
+            switch (state) {
+            case PARSE_VALUE: {
+                uint32_t position = token(index++);
+                switch (source[position]) {
+                case '{':
+                    checkDepth(position);
+                    handler.startObject();
+                    if (index < structurals.size()
+                        && source[structurals[index]] == '}') {
+                        index++;
+                        handler.endObject();
+                        state = PARSE_NEXT;
+                    } else {
+                        containers.push_back('{');
+                        state = PARSE_PROPERTY;
+                    }
+                    break;
+                case '[':
+                    checkDepth(position);
+                    handler.startArray();
+                    if (index < structurals.size()
+                        && source[structurals[index]] == ']') {
+                        index++;
+                        handler.endArray();
+                        state = PARSE_NEXT;
+                    } else {
+                        containers.push_back('[');
+                    }
+                    break;
+                case '"':
+                    readString(position, currentString);
+                    handler.string(currentString);
+                    state = PARSE_NEXT;
+                    break;
+                default:
+                    requireDelimiter(readScalar(position, handler));
+                    state = PARSE_NEXT;
+                    break;
+                }
+                break;
+            }
+
+            case PARSE_PROPERTY: {
+                // "key": value
+                uint32_t position = token(index++);
+                if (source[position] != ESC_QUOTATION_MARK) {
+                    ELSON_THROW(ParseException(
+                        locate(PARSE_SYNTAX_ERROR, position)));
+                }
+                readString(position, currentProperty);
+
+                position = token(index++);
+                if (source[position] != ':') {
+                    ELSON_THROW(ParseException(
+                        locate(PARSE_SYNTAX_ERROR, position)));
+                }
+
+                handler.key(currentProperty);
+                state = PARSE_VALUE;
+                break;
+            }
+
+            case PARSE_NEXT: {
+                if (containers.empty()) {
+                    // Done with the root value
+                    if (index < structurals.size()) {
+                        ELSON_THROW(UnexpectedCharactersException(locate(
+                            PARSE_UNEXPECTED_CHARACTERS, structurals[index])));
+                    }
+                    return;
+                }
+
+                uint32_t position = token(index++);
+                bool inArray = containers.back() == '[';
+                char code = source[position];
+
+                if (code == ',') {
+                    state = inArray ? PARSE_VALUE : PARSE_PROPERTY;
+                } else if (code == ']' && inArray) {
+                    containers.pop_back();
+                    handler.endArray();
+                } else if (code == '}' && !inArray) {
+                    containers.pop_back();
+                    handler.endObject();
+                } else {
+                    ELSON_THROW(ParseException(
+                        locate(PARSE_SYNTAX_ERROR, position)));
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    /**
+     * "..."
+     * Returns the position after the closing quote.
+     */
+    uint32_t FastParser::readString(uint32_t position, std::string& buffer) {
+        const char* end = source + length;
+        const char* error;
+        const char* current = strings::unescape(
+            source + position + 1, end, buffer, error);
+
+        if (!current) {
+            uint32_t codePoint;
+            if (error == end) {
+                ELSON_THROW(UnexpectedEndOfInputException(
+                    locate(PARSE_UNEXPECTED_END, length)));
+            } else if (strings::invalidCodePoint(error, end, codePoint)) {
+                ELSON_THROW(InvalidCodePointException(codePoint,
+                    locate(PARSE_INVALID_CODE_POINT, error - source)));
+            }
+            ELSON_THROW(ParseException(
+                locate(PARSE_SYNTAX_ERROR, error - source)));
+        }
+        return (uint32_t) (current - source);
+    }
+
+    /**
+     * null | true | false
+     * Returns the position after the literal.
+     */
+    uint32_t FastParser::readLiteral(uint32_t position,
+        const char* literal, size_t size) const {
+        if (length - position >= size
+            && memcmp(source + position, literal, size) == 0) {
+            return position + size;
+        }
+
+        // Report the first byte that differs
+        while (position < length && source[position] == *literal) {
+            position++;
+            literal++;
+        }
+        if (position == length) {
+            ELSON_THROW(UnexpectedEndOfInputException(
+                locate(PARSE_UNEXPECTED_END, length)));
+        }
+        ELSON_THROW(ParseException(locate(PARSE_SYNTAX_ERROR, position)));
+    }
+
+    /**
+     * numbers | true | false | null
+     * Returns the position after the scalar.
+     */
+    uint32_t FastParser::readScalar(uint32_t position, Handler& handler) {
+        switch (source[position]) {
+        case 't':
+            position = readLiteral(position, "true", 4);
+            handler.boolean(true);
+            return position;
+        case 'f':
+            position = readLiteral(position, "false", 5);
+            handler.boolean(false);
+            return position;
+        case 'n':
+            position = readLiteral(position, "null", 4);
+            handler.null();
+            return position;
+        default:
+            break;
+        }
+
+        const char* begin = source + position;
+        number::Number result;
+        const char* end = number::scan(begin, source + length, result);
+        if (!end) {
+            ELSON_THROW(ParseException(locate(PARSE_SYNTAX_ERROR, position)));
+        }
+
+        switch (result.type) {
+        case NUMBER_INTEGER:
+            handler.integer(result.integer);
+            break;
+        case NUMBER_UNSIGNED:
+            handler.unsignedInteger(result.uinteger);
+            break;
+        default:
+            handler.number(result.floating);
+            break;
+        }
+        return (uint32_t) (end - source);
+    }
+
+    /**
+     * Entry points
+     */
+    void FastParser::parse(Handler& handler, const char *source,
+        size_t length) {
+        if (length == 0) {
+            return;
+        }
+
+        // Positions are stored in 32 bits
+        if (length > UINT32_MAX) {
+            Parser parser;
+            parser.setMaxDepth(maxDepth);
+            parser.parse(handler, source, length);
+            return;
+        }
+
+        this->source = source;
+        this->length = length;
+
+        buildIndex();
+        walkIndex(handler);
+    }
+
+    void FastParser::parse(Handler& handler, const std::string &source) {
+        parse(handler, source.data(), source.length());
+    }
+
+    void FastParser::parse(Handler& handler, const char *source) {
+        parse(handler, source, strlen(source));
+    }
+
+    void FastParser::parse(Value& value, const char *source, size_t length) {
+        if (length > 0) {
+            value = null;
+            builder.reset(value);
+            parse(builder, source, length);
+        }
+    }
+
+    void FastParser::parse(Value& value, const std::string &source) {
+        parse(value, source.data(), source.length());
+    }
+
+    void FastParser::parse(Value& value, const char *source) {
+        parse(value, source, strlen(source));
+    }
+
+    void FastParser::parse(Document& document, const char *source,
+        size_t length) {
+        document.reset();
+        if (length > 0) {
+            builder.reset(document.getRoot(), document.getKeyTable());
+            parse(builder, source, length);
+        }
+    }
+
+    void FastParser::parse(Document& document, const std::string &source) {
+        parse(document, source.data(), source.length());
+    }
+
+    void FastParser::parse(Document& document, const char *source) {
+        parse(document, source, strlen(source));
+    }
+
+    void FastParser::parseFile(Value& value, const char *path) {
+        MappedFile file(path);
+        parse(value, file.data(), file.size());
+    }
+
+    void FastParser::parseFile(Handler& handler, const char *path) {
+        MappedFile file(path);
+        parse(handler, file.data(), file.size());
+    }
+}
+
+#endif // FASTPARSER_H
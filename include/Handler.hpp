@@ -0,0 +1,172 @@
+#ifndef HANDLER_H
+#define HANDLER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "KeyTable.hpp"
+#include "Value.hpp"
+
+namespace JSON {
+    // Arrays and objects the parsers accept within each other
+    static const size_t default_max_depth = 1024;
+
+    /**
+     * Receives the events of a parse in document order. All methods
+     * do nothing by default so handlers only override what they are
+     * interested in. Strings passed in are only valid during the call.
+     */
+    class Handler {
+    public:
+        virtual ~Handler() { }
+
+        virtual void startObject() { }
+        virtual void key(const std::string& /*key*/) { }
+        virtual void endObject() { }
+
+        virtual void startArray() { }
+        virtual void endArray() { }
+
+        virtual void string(const std::string& /*value*/) { }
+        virtual void number(double /*value*/) { }
+        virtual void boolean(bool /*value*/) { }
+        virtual void null() { }
+
+        // Exact integers, forwarded as double unless overridden
+        virtual void integer(int64_t value) {
+            number((double) value);
+        }
+
+        virtual void unsignedInteger(uint64_t value) {
+            number((double) value);
+        }
+    };
+
+    /**
+     * Builds a Value tree from the events. Strings and containers are
+     * allocated like the root value (e.g. from the arena of a
+     * Document). Keys are interned if a KeyTable is given. Builders
+     * can be reused to keep their buffers.
+     */
+    class ValueBuilder : public Handler {
+    public:
+        ValueBuilder() : root(0), keys(0) { }
+
+        ValueBuilder(Value& root, KeyTable * keys = 0)
+        : root(&root), keys(keys) { }
+
+        // Build into root next
+        void reset(Value& root, KeyTable * keys = 0) {
+            this->root = &root;
+            this->keys = keys;
+            containers.clear();
+        }
+
+        void startObject() {
+            Value& object = slot();
+            Object& entries = object.asMutable<Object>();
+
+            // Records tend to have the same number of keys as the
+            // previous object at the same depth
+            size_t depth = containers.size();
+            if (depth < shapes.size()) {
+                entries.reserve(shapes[depth]);
+            }
+            containers.push_back(&object);
+        }
+
+        void key(const std::string& key) {
+            currentProperty = key;
+        }
+
+        void endObject() {
+            Object& object = containers.back()->asMutable<Object>();
+            object.finish(order);
+            containers.pop_back();
+
+            size_t depth = containers.size();
+            if (depth >= shapes.size()) {
+                shapes.resize(depth + 1);
+            }
+            shapes[depth] = object.size();
+        }
+
+        void startArray() {
+            Value& array = slot();
+            array.asMutable<Array>();
+            containers.push_back(&array);
+        }
+
+        void endArray() {
+            containers.pop_back();
+        }
+
+        void string(const std::string& value) {
+            slot().asMutable<String>().assign(value.data(), value.length());
+        }
+
+        void number(double value) {
+            slot() = value;
+        }
+
+        void integer(int64_t value) {
+            slot() = value;
+        }
+
+        void unsignedInteger(uint64_t value) {
+            slot() = value;
+        }
+
+        void boolean(bool value) {
+            slot() = value;
+        }
+
+        void null() {
+            slot() = Value();
+        }
+
+    private:
+        // The place for the next value: appended to the current
+        // array, stored under the current key of the current object
+        // or the root itself.
+        Value& slot() {
+            if (containers.empty()) {
+                return *root;
+            }
+
+            Value& top = *containers.back();
+            if (top.is(JSON_ARRAY)) {
+                Array& array = top.asMutable<Array>();
+                array.push_back(Value());
+                return array.back();
+            }
+
+            // Completed (sorted) by endObject()
+            Object& object = top.asMutable<Object>();
+            if (keys) {
+                return object.append(keys->intern(currentProperty));
+            }
+            return object.append(
+                currentProperty.data(), currentProperty.length());
+        }
+
+        Value * root;
+
+        // Interns keys if set
+        KeyTable * keys;
+        std::string currentProperty;
+
+        // Open arrays and objects. Their addresses are stable while
+        // they are open since only the innermost one grows.
+        std::vector<Value *> containers;
+
+        // Scratch space for sorting the keys of large objects
+        std::vector<size_t> order;
+
+        // Size of the last object completed at each depth
+        std::vector<size_t> shapes;
+    };
+}
+
+#endif // HANDLER_H
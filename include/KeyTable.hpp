@@ -0,0 +1,145 @@
+#ifndef KEYTABLE_H
+#define KEYTABLE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+#include "MemoryResource.hpp"
+#include "Value.hpp"
+
+namespace JSON {
+    /**
+     * Interns object keys: every distinct key is stored once and all
+     * Keys handed out for it share these characters, so records with
+     * the same field names do not repeat them and equal keys compare
+     * by pointer. Keys short enough to be stored inline are returned
+     * as they are.
+     *
+     * Interned keys must not outlive the table (or its last clear()).
+     */
+    class KeyTable {
+        public:
+            KeyTable(MemoryResource * resource = 0)
+            : resource(resource), count(0) { }
+
+            ~KeyTable() {
+                clear();
+            }
+
+            Key intern(const char * key, size_t length);
+
+            Key intern(const std::string& key) {
+                return intern(key.data(), key.length());
+            }
+
+            // Number of distinct interned keys
+            size_t size() const {
+                return count;
+            }
+
+            // Forget all keys. The slots are kept for reuse.
+            void clear();
+
+        private:
+            KeyTable(const KeyTable&);
+            KeyTable& operator=(const KeyTable&);
+
+            // Filled up to half of the slots before growing
+            static const size_t INITIAL_SIZE = 64;
+
+            struct Entry {
+                const char * characters;
+                uint32_t length;
+                uint32_t hash;
+            };
+
+            void grow();
+
+            // Characters are allocated from here
+            MemoryResource * resource;
+
+            // Open addressing with linear probing, empty slots have
+            // no characters
+            std::vector<Entry> slots;
+            size_t count;
+    };
+
+    Key KeyTable::intern(const char* key, size_t length) {
+        Key result;
+        if (length <= Key::LOCAL_SIZE) {
+            result.assign(key, length);
+            return result;
+        }
+
+        if ((count + 1) * 2 > slots.size()) {
+            grow();
+        }
+
+        size_t hash = Key::hash(key, length);
+        size_t mask = slots.size() - 1;
+        size_t slot = hash & mask;
+        for (; slots[slot].characters; slot = (slot + 1) & mask) {
+            const Entry& entry = slots[slot];
+            if (entry.hash == (uint32_t) hash && entry.length == length
+                && memcmp(entry.characters, key, length) == 0) {
+                result.setRemote(entry.characters, length, Key::INTERNED);
+                return result;
+            }
+        }
+
+        char* characters = Allocator<char>(resource).allocate(length + 1);
+        memcpy(characters, key, length);
+        characters[length] = 0;
+
+        Entry& entry = slots[slot];
+        entry.characters = characters;
+        entry.length = (uint32_t) length;
+        entry.hash = (uint32_t) hash;
+        count++;
+
+        result.setRemote(characters, length, Key::INTERNED);
+        return result;
+    }
+
+    void KeyTable::grow() {
+        std::vector<Entry> old;
+        old.swap(slots);
+
+        Entry empty = { 0, 0, 0 };
+        slots.assign(old.empty() ? INITIAL_SIZE : old.size() * 2, empty);
+
+        // The low bits of the stored hash are enough to find the
+        // new slot
+        size_t mask = slots.size() - 1;
+        for (size_t index = 0; index < old.size(); index++) {
+            if (old[index].characters) {
+                size_t slot = old[index].hash & mask;
+                while (slots[slot].characters) {
+                    slot = (slot + 1) & mask;
+                }
+                slots[slot] = old[index];
+            }
+        }
+    }
+
+    void KeyTable::clear() {
+        if (count == 0) {
+            return;
+        }
+
+        bool monotonic = resource && resource->isMonotonic();
+        for (size_t index = 0; index < slots.size(); index++) {
+            Entry& entry = slots[index];
+            if (entry.characters && !monotonic) {
+                Allocator<char>(resource).deallocate(
+                    (char*) entry.characters, entry.length + 1);
+            }
+            entry.characters = 0;
+        }
+        count = 0;
+    }
+}
+
+#endif // KEYTABLE_H
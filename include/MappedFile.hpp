@@ -0,0 +1,111 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <errno.h>
+
+#if defined(_WIN32)
+#   include <fstream>
+#   include <sstream>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+#include "Exceptions.hpp"
+
+namespace JSON {
+    /**
+     * A whole file mapped read-only into memory. Pages are read on
+     * first access, so parsing can start right away and the contents
+     * are not copied out of the page cache. Other platforms read the
+     * file into a buffer instead.
+     */
+    class MappedFile {
+        public:
+            MappedFile(const char * path);
+            ~MappedFile();
+
+            const char * data() const {
+                return begin;
+            }
+
+            size_t size() const {
+                return length;
+            }
+
+        private:
+            MappedFile(const MappedFile&);
+            MappedFile& operator=(const MappedFile&);
+
+            const char * begin;
+            size_t length;
+
+#if defined(_WIN32)
+            std::string buffer;
+#endif
+    };
+
+#if defined(_WIN32)
+    MappedFile::MappedFile(const char* path)
+    : begin(0), length(0) {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file) {
+            ELSON_THROW(FileException(path, errno));
+        }
+        std::stringstream contents;
+        contents << file.rdbuf();
+        buffer = contents.str();
+        begin = buffer.data();
+        length = buffer.length();
+    }
+
+    MappedFile::~MappedFile() { }
+#else
+    MappedFile::MappedFile(const char* path)
+    : begin(""), length(0) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            ELSON_THROW(FileException(path, errno));
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            int error = errno;
+            close(fd);
+            ELSON_THROW(FileException(path, error));
+        }
+
+        // Empty files can not be mapped
+        if (info.st_size > 0) {
+            void* mapping = mmap(0, (size_t) info.st_size, PROT_READ,
+                MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                int error = errno;
+                close(fd);
+                ELSON_THROW(FileException(path, error));
+            }
+
+            // The parsers read front to back: read ahead aggressively
+            // and drop pages behind.
+            madvise(mapping, (size_t) info.st_size, MADV_SEQUENTIAL);
+
+            begin = (const char*) mapping;
+            length = (size_t) info.st_size;
+        }
+
+        // The mapping stays valid without the descriptor
+        close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if (length > 0) {
+            munmap((void*) begin, length);
+        }
+    }
+#endif
+}
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,71 @@
+#ifndef MEMORYRESOURCE_H
+#define MEMORYRESOURCE_H
+
+#include <stddef.h>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#   if __has_include(<memory_resource>)
+#       include <memory_resource>
+#       define ELSON_HAS_PMR
+#   endif
+#endif
+
+namespace JSON {
+    /**
+     * Source of memory for strings and containers, modelled after
+     * std::pmr::memory_resource. Values without a resource use the
+     * heap.
+     */
+    class MemoryResource {
+        public:
+            virtual ~MemoryResource() { }
+
+            virtual void * allocate(size_t size, size_t alignment) = 0;
+            virtual void deallocate(void * memory, size_t size,
+                size_t alignment) = 0;
+
+            // True if deallocate does nothing and memory is reclaimed
+            // by the owner of the resource all at once. Values then
+            // skip destroying their payloads one by one.
+            virtual bool isMonotonic() const {
+                return false;
+            }
+    };
+
+#if defined(ELSON_HAS_PMR)
+    /**
+     * Adapts a std::pmr::memory_resource (pools, monotonic buffers or
+     * custom resources) for use by Values.
+     */
+    class PmrResource : public MemoryResource {
+        public:
+            // Pass monotonic = true for resources that never free
+            // single allocations, like std::pmr::monotonic_buffer_resource
+            PmrResource(std::pmr::memory_resource * upstream,
+                bool monotonic = false)
+            : upstream(upstream), monotonic(monotonic) { }
+
+            void * allocate(size_t size, size_t alignment) {
+                return upstream->allocate(size, alignment);
+            }
+
+            void deallocate(void * memory, size_t size, size_t alignment) {
+                upstream->deallocate(memory, size, alignment);
+            }
+
+            bool isMonotonic() const {
+                return monotonic;
+            }
+
+            std::pmr::memory_resource * getUpstream() const {
+                return upstream;
+            }
+
+        private:
+            std::pmr::memory_resource * upstream;
+            bool monotonic;
+    };
+#endif
+}
+
+#endif // MEMORYRESOURCE_H
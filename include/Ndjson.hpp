@@ -0,0 +1,314 @@
+#ifndef NDJSON_H
+#define NDJSON_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <string.h>
+
+#include "Exceptions.hpp"
+#include "Parser.hpp"
+
+namespace JSON {
+    // A record that failed to parse
+    struct NdjsonError {
+        size_t index;           // zero based line of the record
+        size_t offset;          // of the line start within the input
+        std::string message;
+    };
+
+    /**
+     * Reads newline delimited JSON (one document per line) on a pool
+     * of worker threads, each with its own Parser. The input is split
+     * into line aligned chunks which the workers claim one at a time.
+     *
+     * Blank lines are skipped but still count as lines, so record
+     * indices are line numbers. Records that do not parse are reported
+     * with their index and byte offset and do not stop the others.
+     *
+     * Not included by Elson.hpp since it needs threads (-pthread).
+     */
+    class NdjsonReader {
+        public:
+            typedef std::function<void(size_t index, Value& value)>
+                RecordCallback;
+
+            // threads = 0 uses one worker per core
+            NdjsonReader(unsigned int threads = 0,
+                size_t chunkSize = 1 << 16)
+            : threads(threads), chunkSize(chunkSize ? chunkSize : 1) {
+                if (this->threads == 0) {
+                    this->threads = std::max(1u,
+                        std::thread::hardware_concurrency());
+                }
+            }
+
+            // Delivers the records on the calling thread in input
+            // order. Returns the errors sorted by index.
+            std::vector<NdjsonError> read(const char * source,
+                size_t length, RecordCallback onRecord);
+            std::vector<NdjsonError> read(const std::string& source,
+                RecordCallback onRecord);
+
+            // Delivers the records on the worker threads as soon as
+            // they are parsed, onRecord must be thread safe.
+            std::vector<NdjsonError> readUnordered(const char * source,
+                size_t length, RecordCallback onRecord);
+            std::vector<NdjsonError> readUnordered(
+                const std::string& source, RecordCallback onRecord);
+
+        private:
+            struct Record {
+                Record(size_t index) : index(index) { }
+                size_t index;
+                Value value;
+            };
+
+            struct Chunk {
+                const char * begin;
+                const char * end;
+                size_t firstLine;
+                bool ready;
+
+                // Parsed records waiting for in order delivery
+                std::vector<Record> records;
+                std::vector<NdjsonError> errors;
+            };
+
+            std::vector<NdjsonError> run(const char * source,
+                size_t length, RecordCallback& onRecord, bool ordered);
+
+            void split(const char * source, size_t length);
+
+            // Run work(workerIndex) on every worker and wait for them
+            void runWorkers(const std::function<void(unsigned int)>& work);
+
+            void parseChunk(Parser& parser, Chunk& chunk,
+                const char * source, RecordCallback* onRecord);
+
+            unsigned int threads;
+            size_t chunkSize;
+
+            std::vector<Chunk> chunks;
+    };
+
+    /**
+     * Chunks end after a newline (or at the end of the input)
+     */
+    void NdjsonReader::split(const char* source, size_t length) {
+        chunks.clear();
+        const char* end = source + length;
+        const char* begin = source;
+
+        while (begin < end) {
+            Chunk chunk;
+            chunk.begin = begin;
+            chunk.end = end;
+            chunk.firstLine = 0;
+            chunk.ready = false;
+
+            if ((size_t) (end - begin) > chunkSize) {
+                const char* newline = (const char*) memchr(
+                    begin + chunkSize, '\n', end - begin - chunkSize);
+                if (newline) {
+                    chunk.end = newline + 1;
+                }
+            }
+
+            chunks.push_back(chunk);
+            begin = chunk.end;
+        }
+    }
+
+    void NdjsonReader::runWorkers(
+        const std::function<void(unsigned int)>& work) {
+        std::vector<std::thread> workers;
+        for (unsigned int index = 0; index < threads; index++) {
+            workers.push_back(std::thread(work, index));
+        }
+        for (size_t index = 0; index < workers.size(); index++) {
+            workers[index].join();
+        }
+    }
+
+    /**
+     * Parse every line of a chunk. Records are either passed to
+     * onRecord right away or kept in the chunk.
+     */
+    void NdjsonReader::parseChunk(Parser& parser, Chunk& chunk,
+        const char* source, RecordCallback* onRecord) {
+        size_t line = chunk.firstLine;
+        const char* begin = chunk.begin;
+
+        while (begin < chunk.end) {
+            const char* end = (const char*) memchr(
+                begin, '\n', chunk.end - begin);
+            if (!end) {
+                end = chunk.end;
+            }
+
+            if (simd::skipWhitespace(begin, end) < end) {
+                Record record(line);
+                // Invalid lines are expected, do not pay for exceptions
+                ParseError failure = parser.tryParse(
+                    record.value, begin, end - begin);
+                if (failure) {
+                    NdjsonError error = {
+                        line, (size_t) (begin - source), failure.message()
+                    };
+                    chunk.errors.push_back(error);
+                    begin = end + 1;
+                    line++;
+                    continue;
+                }
+
+                if (onRecord) {
+                    (*onRecord)(record.index, record.value);
+                } else {
+                    chunk.records.push_back(std::move(record));
+                }
+            }
+
+            begin = end + 1;
+            line++;
+        }
+    }
+
+    std::vector<NdjsonError> NdjsonReader::run(const char* source,
+        size_t length, RecordCallback& onRecord, bool ordered) {
+        split(source, length);
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        size_t nextChunk = 0;
+        std::exception_ptr failure;
+
+        // Count the lines of every chunk first so that each one
+        // knows the index of its first record.
+        std::vector<size_t> lines(chunks.size());
+        runWorkers([&](unsigned int worker) {
+            for (size_t index = worker; index < chunks.size();
+                 index += threads) {
+                lines[index] = std::count(
+                    chunks[index].begin, chunks[index].end, '\n');
+            }
+        });
+        for (size_t index = 1; index < chunks.size(); index++) {
+            chunks[index].firstLine =
+                chunks[index - 1].firstLine + lines[index - 1];
+        }
+
+        // Chunks parsed ahead of the delivery are held in memory,
+        // limit how far the workers may get ahead.
+        size_t delivered = 0;
+        size_t window = ordered ? 4 * threads : chunks.size();
+
+        std::thread pool([&]() {
+            runWorkers([&](unsigned int) {
+                Parser parser;
+                for (;;) {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() {
+                        return failure || nextChunk == chunks.size()
+                            || nextChunk < delivered + window;
+                    });
+                    if (failure || nextChunk == chunks.size()) {
+                        return;
+                    }
+                    Chunk& chunk = chunks[nextChunk++];
+                    lock.unlock();
+
+                    try {
+                        parseChunk(parser, chunk, source,
+                            ordered ? 0 : &onRecord);
+                    } catch (...) {
+                        // Thrown by the callback
+                        lock.lock();
+                        failure = std::current_exception();
+                        changed.notify_all();
+                        return;
+                    }
+
+                    lock.lock();
+                    chunk.ready = true;
+                    changed.notify_all();
+                }
+            });
+        });
+
+        std::vector<NdjsonError> errors;
+        for (size_t index = 0; index < chunks.size(); index++) {
+            Chunk& chunk = chunks[index];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() {
+                    return failure || chunk.ready;
+                });
+                if (failure) {
+                    break;
+                }
+            }
+
+            if (ordered) {
+                try {
+                    for (size_t record = 0; record < chunk.records.size();
+                         record++) {
+                        onRecord(chunk.records[record].index,
+                            chunk.records[record].value);
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    failure = std::current_exception();
+                    changed.notify_all();
+                    break;
+                }
+                std::vector<Record>().swap(chunk.records);
+            }
+
+            errors.insert(errors.end(),
+                chunk.errors.begin(), chunk.errors.end());
+
+            std::lock_guard<std::mutex> lock(mutex);
+            delivered++;
+            changed.notify_all();
+        }
+
+        pool.join();
+        chunks.clear();
+
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+        return errors;
+    }
+
+    /**
+     * Entry points
+     */
+    std::vector<NdjsonError> NdjsonReader::read(const char* source,
+        size_t length, RecordCallback onRecord) {
+        return run(source, length, onRecord, true);
+    }
+
+    std::vector<NdjsonError> NdjsonReader::read(const std::string& source,
+        RecordCallback onRecord) {
+        return run(source.data(), source.length(), onRecord, true);
+    }
+
+    std::vector<NdjsonError> NdjsonReader::readUnordered(
+        const char* source, size_t length, RecordCallback onRecord) {
+        return run(source, length, onRecord, false);
+    }
+
+    std::vector<NdjsonError> NdjsonReader::readUnordered(
+        const std::string& source, RecordCallback onRecord) {
+        return run(source.data(), source.length(), onRecord, false);
+    }
+}
+
+#endif // NDJSON_H
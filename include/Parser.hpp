@@ -1,55 +1,114 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include <stack>
-#include <ctype.h>
+#include <vector>
 #include <stdint.h>
+#include <string.h>
 
-#include "Utf8.hpp"
+#include "Document.hpp"
+#include "Handler.hpp"
+#include "MappedFile.hpp"
+#include "Simd.hpp"
+#include "Strings.hpp"
 #include "Value.hpp"
 
 namespace JSON {
-    // JSON escape characters that may appear
-    // after a reverse solidus
-    const char ESC_REVERSE_SOLIUDS  = 92;
-    const char ESC_QUOTATION_MARK   = 34;
-    const char ESC_SOLIDUS          = 47;
-    const char ESC_BACKSPACE        = 98;
-    const char ESC_FORMFEED         = 102;
-    const char ESC_NEWLINE          = 110;
-    const char ESC_CARRET           = 114;
-    const char ESC_HORIZONTAL_TAB   = 116;
-    const char ESC_UNICODE          = 117;
-    
-    // Use 32 bit characters for unicode strings
-    typedef std::basic_string<int32_t> wideString;
-
-    // Represents a JSON parser
+    // Describe an error at offset in source. Lines and columns are
+    // not tracked while parsing, they are found by scanning the input
+    // up to the error.
+    inline ParseError locateError(ParseErrorCode code, const char * source,
+        size_t offset) {
+        size_t lineStart = offset;
+        while (lineStart > 0 && source[lineStart - 1] != '\n') {
+            lineStart--;
+        }
+
+        ParseError error;
+        error.code = code;
+        error.offset = offset;
+        error.line = simd::countNewlines(source, source + lineStart) + 1;
+        error.column = offset - lineStart + 1;
+        return error;
+    }
+
+    /**
+     * Represents a JSON parser. Open arrays and objects are kept on
+     * an explicit stack instead of recursing, so deeply nested input
+     * cannot exhaust the call stack. Documents nested deeper than
+     * getMaxDepth() are rejected with a NestingDepthException.
+     */
     class Parser {
         public:
-            Parser() : parseIndex(0), lineNumber(1) { }
+            Parser()
+            : parseIndex(0), source(0), length(0), handler(0),
+              maxDepth(default_max_depth) {
+                // Typical nesting does not allocate while parsing
+                containers.reserve(64);
+            }
+
+            // Arrays and objects allowed within each other
+            size_t getMaxDepth() const {
+                return maxDepth;
+            }
 
-            void parse(Value& object, const std::string& source) throw(std::exception);
-            void parse(Value& object, const char * source) throw(std::exception);
+            void setMaxDepth(size_t depth) {
+                maxDepth = depth;
+            }
+
+            void parse(Value& object, const std::string& source);
+            void parse(Value& object, const char * source);
+
+            // Parse directly from a caller owned buffer without
+            // copying it. The buffer is only accessed during the call.
+            void parse(Value& object, const char * source, size_t length);
+
+            // Reset the document and parse into its arena
+            void parse(Document& document, const std::string& source);
+            void parse(Document& document, const char * source);
+            void parse(Document& document, const char * source, size_t length);
+
+            // Report the document to a handler instead of building
+            // a Value.
+            void parse(Handler& handler, const std::string& source);
+            void parse(Handler& handler, const char * source);
+            void parse(Handler& handler, const char * source, size_t length);
+
+            // Parse a file through a read-only memory mapping
+            void parseFile(Value& object, const char * path);
+            void parseFile(Handler& handler, const char * path);
+
+            // Parse without throwing: invalid input is reported in the
+            // returned error instead, which does not allocate. The
+            // target holds whatever was parsed up to the error.
+            ParseError tryParse(Value& object, const std::string& source);
+            ParseError tryParse(Value& object, const char * source);
+            ParseError tryParse(Value& object, const char * source,
+                size_t length);
+            ParseError tryParse(Document& document, const std::string& source);
+            ParseError tryParse(Document& document, const char * source);
+            ParseError tryParse(Document& document, const char * source,
+                size_t length);
+            ParseError tryParse(Handler& handler, const std::string& source);
+            ParseError tryParse(Handler& handler, const char * source);
+            ParseError tryParse(Handler& handler, const char * source,
+                size_t length);
 
         private:
             void reset() {
-                lineNumber = 1;
                 parseIndex = 0;
-                while(!objectStack.empty()) {
-                    objectStack.pop();
-                }
+                source = 0;
+                length = 0;
+                handler = 0;
+                error = ParseError();
             }
         
             // Increment the parse index until a non-whitespace character
             // is encountered.
             void clearWhitespace() {
-                while (hasNext() && isspace(source.at(parseIndex))) {
-                    if (peek() == 10 || peek() == 12 || peek() == 13) {
-                        lineNumber++;
-                    }
-                    parseIndex++;
-                }
+                const char* begin = source + parseIndex;
+                const char* end = simd::skipWhitespace(
+                    begin, source + length);
+                parseIndex += end - begin;
             }
 
             // Increase the parse index but ignore the current character
@@ -59,73 +118,14 @@ namespace JSON {
 
             // End of Stream reached?
             bool hasNext() const {
-                return parseIndex < source.length();
+                return parseIndex < length;
             }
-                
-            // Return a reference to the current character in the
-            // stream and increase the index.
-            char& next() throw(UnexpectedEndOfInputException) {
-                if (!hasNext()) {
-                    // End of Stream already reached?
-                    throw UnexpectedEndOfInputException(lineNumber);
-                }
-                // Increase the line number. This is used to print
-                // the position when a parse error occurs.
-                if (peek() == '\n') {
-                    lineNumber++;
-                }
 
-                return source.at(parseIndex++);
-            }
-
-            // Return a reference to the current character in the
-            // stream without increasing the index.
-            char& peek() throw(UnexpectedEndOfInputException) {
-                if (!hasNext()) {
-                    // End of Stream already reached?
-                    throw UnexpectedEndOfInputException(lineNumber);
-                }
-                return source.at(parseIndex);
-            }
-
-            // Return a reference to the top item on the stack.
-            // The top item usually holds a reference to the 
-            // current array / object at the parse position.
-            Value& top() const {
-                return *objectStack.top();
-            }
-
-            // Store a parsed value and return a reference
-            // to it
-            Value& store(const Value& val) {
-                if (top().is(JSON_ARRAY)) {
-                    // Current parse position is inside an array:
-                    // Append the new item to the end of the array
-                    top().push_back(val);
-                    return top().asMutable<Array>().back();
-                } else if (top().is(JSON_OBJECT)) {
-                    // Current parse position is inside an object:
-                    // Read the current property and store the new item
-                    // under this property inside the current object.
-                    top()[currentProperty.str().c_str()] = val;
-                    return top()[currentProperty.str().c_str()];
-                } else {
-                    // Parse position is not inside an array and not
-                    // inside an object. Put the new item on the top
-                    // of the stack.
-                    top() = val;
-                    return top();
-                }
-            }
-
-            // Tests if a character is allowed for numeric expressions.
-            bool validNumericChar(char code) const {
-                return (code >= 48 && code <= 57)
-                    || (code == 46)     // '.'
-                    || (code == 45)     // '-'
-                    || (code == 43)     // '+'
-                    || (code == 69)     // 'E'                    
-                    || (code == 101);   // 'e'
+            // Return the current character in the stream without
+            // increasing the index, 0 at the end of the stream. No
+            // valid token starts with 0.
+            char peek() const {
+                return hasNext() ? source[parseIndex] : 0;
             }
 
             // Tests if a character is allowed to introduce a numeric
@@ -135,354 +135,471 @@ namespace JSON {
                     || (code == 45);    // '-'
             }
 
-            // Valid digit within an \u2360 unicode escape?
-            bool validHexDigit(char code) const {
-                return (code >= 48 && code <= 57)
-                    || (code >= 65 && code <= 70)
-                    || (code >= 97 && code <= 102);
+            // Record an error and return false to unwind
+            bool fail(ParseErrorCode code, size_t offset);
+
+            // The current character is not what was expected
+            bool unexpected() {
+                return hasNext()
+                    ? fail(PARSE_SYNTAX_ERROR, parseIndex)
+                    : fail(PARSE_UNEXPECTED_END, length);
             }
 
-            void parseObject()      throw(std::exception);
-            void parseProperty()    throw(std::exception);
-            void parseValue()       throw(std::exception);
-            void parseString()      throw(std::exception);
-            void parseArray()       throw(std::exception);
-            void parseBoolean()     throw(std::exception);
-            void parseNumber()      throw(std::exception);
-            void parseNull()        throw(std::exception);
-            void escapeChar()       throw(std::exception);
-            void readUTF8Escape()   throw(std::exception);
+            // Throw the exception for the recorded error
+            void raise() const;
+
+            bool parseDocument(Handler& handler, const char * source,
+                size_t length);
+            bool parseValue();
+            bool openContainer(char code);
+            char close();
+            bool parseKey();
+            bool parseString();
+            bool parseBoolean();
+            bool parseNumber();
+            bool parseNull();
+            bool parseLiteral(const char* literal, size_t size);
+            bool readString(std::string& buffer);
                         
-            unsigned int parseIndex;
-            unsigned int lineNumber;
-
-            std::string source;
-            std::ostringstream currentProperty;
-            std::ostringstream currentString;
-            
-            // Since std::stack<Value&> is not possible use
-            // a pointer here
-            std::stack<Value *> objectStack;
+            size_t parseIndex;
+
+            // Input buffer, owned by the caller
+            const char * source;
+            size_t length;
+
+            // Reusable buffers for keys and string values
+            std::string currentProperty;
+            std::string currentString;
+
+            // Builds Values, kept to reuse its buffers
+            ValueBuilder builder;
+
+            // Receives the parsed values
+            Handler * handler;
+
+            // Open arrays ('[') and objects ('{')
+            std::vector<char> containers;
+            size_t maxDepth;
+
+            // Set by fail()
+            ParseError error;
     };
 
+    bool Parser::fail(ParseErrorCode code, size_t offset) {
+        error = locateError(code, source, offset);
+        return false;
+    }
+
+    void Parser::raise() const {
+        uint32_t codePoint = 0;
+        switch (error.code) {
+        case PARSE_UNEXPECTED_END:
+            ELSON_THROW(UnexpectedEndOfInputException(error));
+        case PARSE_UNEXPECTED_CHARACTERS:
+            ELSON_THROW(UnexpectedCharactersException(error));
+        case PARSE_INVALID_CODE_POINT:
+            if (strings::readHex4(source + error.offset, source + length,
+                codePoint)) {
+                ELSON_THROW(InvalidCodePointException(codePoint, error));
+            }
+            ELSON_THROW(ParseException(error));
+        case PARSE_TOO_DEEP:
+            ELSON_THROW(NestingDepthException(maxDepth, error));
+        default:
+            ELSON_THROW(ParseException(error));
+        }
+    }
+
     /**
-     * { ... }
+     * A value, with all arrays and objects in it. Whenever a container
+     * is opened the loop continues with its first value and once a
+     * value is complete the open containers decide what follows.
      */
-    void Parser::parseObject() throw(std::exception) {
-        clearWhitespace();
-        if (next() == '{') {
+    bool Parser::parseValue() {
+        containers.clear();
+
+        // Innermost open container, cached next to the stack
+        char current = 0;
+
+        for (;;) {
             clearWhitespace();
-            
-            // Push a new object on the stack
-            objectStack.push(&store(Object {}));
-            
-            if (peek() != '}') {
-                // Parse object properties
-                while (hasNext()) {
-                    parseProperty();
-                    clearWhitespace();
-
-                    if (hasNext() && peek() != ',') {
-                        break;
-                    } else {
-                        // Another property to parse. Get rid
-                        // of the ',' and go on...
-                        consume(); // ','
+
+            // Decide the type of the value on the stream
+            switch (peek()) {
+            case '{':
+                if (!openContainer('{')) {
+                    return false;
+                }
+                current = '{';
+                handler->startObject();
+                clearWhitespace();
+                if (peek() != '}') {
+                    if (!parseKey()) {
+                        return false;
                     }
+                    // Continue with the value of the first property
+                    continue;
                 }
-            }
-            
-            // End of properties
-            clearWhitespace();
-            
-            if (peek() == '}') {
                 consume(); // '}'
-                // Done with parsing the object.
-                // Pop it from the stack, since this is no longer
-                // the reference object for eventual coming items.
-                objectStack.pop();
-                return;
-            } else {
-                // Objects must end with ...}
-                throw ParseException(lineNumber);
+                current = close();
+                handler->endObject();
+                break;
+            case '[':
+                if (!openContainer('[')) {
+                    return false;
+                }
+                current = '[';
+                handler->startArray();
+                clearWhitespace();
+                if (peek() != ']') {
+                    // Continue with the first element
+                    continue;
+                }
+                consume(); // ']'
+                current = close();
+                handler->endArray();
+                break;
+            case '"':
+                if (!parseString()) {
+                    return false;
+                }
+                break;
+            case 'n':
+                if (!parseNull()) {
+                    return false;
+                }
+                break;
+            case 't':
+            case 'f':
+                if (!parseBoolean()) {
+                    return false;
+                }
+                break;
+            default:
+                // If none of the former types matched always try to
+                // parse a number.
+                if (!validNumericStartingChar(peek())) {
+                    return unexpected();
+                }
+                if (!parseNumber()) {
+                    return false;
+                }
+                break;
             }
 
-        } else {
-            // Objects have to start with {...
-            throw ParseException(lineNumber);
+            // A value is complete. Close containers until one of them
+            // continues with another value.
+            for (;;) {
+                if (!current) {
+                    return true;
+                }
+                clearWhitespace();
+
+                char code = peek();
+                if (code == ',') {
+                    consume(); // ','
+                    if (current == '{' && !parseKey()) {
+                        return false;
+                    }
+                    break;
+                } else if (code == ']' && current == '[') {
+                    consume(); // ']'
+                    current = close();
+                    handler->endArray();
+                } else if (code == '}' && current == '{') {
+                    consume(); // '}'
+                    current = close();
+                    handler->endObject();
+                } else {
+                    // Elements are separated by ',' and containers
+                    // end with the matching bracket
+                    return unexpected();
+                }
+            }
         }
     }
 
     /**
-     * ...:
+     * { | [
      */
-    void Parser::parseProperty() throw(std::exception) {
-        // Reset currentProperty buffer
-        currentProperty.str(""); 
-        clearWhitespace();
-        
-        // Properties must start with '"'
-        if (peek() == ESC_QUOTATION_MARK) {
-            consume(); // '"'
-            while (peek() != ESC_QUOTATION_MARK) {
-                currentProperty << next();
-            }
-            
-            // Properties must end with '"'
-            if (next() != ESC_QUOTATION_MARK) {
-                throw ParseException(lineNumber);
-            } else {
-                clearWhitespace();
-                // ...": ...
-                // Properties must be in the form of
-                // "key": value
-                if (peek() != ':') {
-                    throw ParseException(lineNumber);
-                } else {
-                    consume(); // ':'
-                    // Parse the value
-                    // :... 
-                    parseValue();
-                }
-            }
-        } else {
-            throw ParseException(lineNumber);
+    bool Parser::openContainer(char code) {
+        if (containers.size() >= maxDepth) {
+            return fail(PARSE_TOO_DEEP, parseIndex);
         }
+        containers.push_back(code);
+        consume();
+        return true;
     }
 
     /**
-     * :...
+     * ] | }, returns the container that is open afterwards
      */
-    void Parser::parseValue() throw(std::exception) {
+    char Parser::close() {
+        containers.pop_back();
+        return containers.empty() ? 0 : containers.back();
+    }
+
+    /**
+     * "key":
+     */
+    bool Parser::parseKey() {
         clearWhitespace();
-        
-        // Decide the type of the value on the stream
-        switch(peek()) {
-            case '{':
-                parseObject();
-                return;
-            case '"':
-                parseString();
-                return;
-            case '[':
-                parseArray();
-                return;
-            case 'n':
-              parseNull();
-              return;
-            case 't':
-            case 'f':
-                parseBoolean();
-                return;
-            default:
-                // If none of the former types matched always try to
-                // parse a number.
-                if (validNumericStartingChar(peek())) {
-                    parseNumber();
-                    return;
-                } else {
-                    throw ParseException(lineNumber);
-                }
+
+        // Properties must start with '"'
+        if (peek() != ESC_QUOTATION_MARK) {
+            return unexpected();
+        }
+        if (!readString(currentProperty)) {
+            return false;
         }
+        handler->key(currentProperty);
+        clearWhitespace();
+
+        // Properties must be in the form of
+        // "key": value
+        if (peek() != ':') {
+            return unexpected();
+        }
+        consume(); // ':'
+        return true;
     }
 
     /**
      * null
      */
-    void Parser::parseNull() throw(std::exception) {
-      currentString.str("");
-      
-      // Read the next four characters and test if they
-      // are equal to 'null'
-      for (int i=0;i<4;i++) {
-          currentString << next();
-      }
-      
-      if (currentString.str().compare("null") == 0) {
-          store(Value());
-      } else {
-        throw ParseException(lineNumber);
-      }
+    bool Parser::parseNull() {
+        if (!parseLiteral("null", 4)) {
+            return false;
+        }
+        handler->null();
+        return true;
     }
 
     /**
-     * numbers
+     * null | true | false
+     * Compare the literal in place.
      */
-    void Parser::parseNumber() throw(std::exception) {
-        currentString.str("");
-        while (hasNext() && validNumericChar(peek())) {
-            currentString << next();
+    bool Parser::parseLiteral(const char* literal, size_t size) {
+        if (length - parseIndex >= size
+            && memcmp(source + parseIndex, literal, size) == 0) {
+            parseIndex += size;
+            return true;
         }
 
-        store(fromString<double>(currentString.str()));
+        // Report the first byte that differs
+        while (hasNext() && source[parseIndex] == *literal) {
+            parseIndex++;
+            literal++;
+        }
+        return unexpected();
     }
 
     /**
-     * true | false 
+     * numbers
      */
-    void Parser::parseBoolean() throw(std::exception) {
-        currentString.str("");
-        // consume lowercase letters
-        while (hasNext() && peek() >= 97 && peek() <= 122) {
-            currentString << next();
+    bool Parser::parseNumber() {
+        // Scan directly on the input buffer
+        const char* begin = source + parseIndex;
+        const char* end = source + length;
+
+        number::Number result;
+        end = number::scan(begin, end, result);
+        if (!end) {
+            return fail(PARSE_SYNTAX_ERROR, parseIndex);
+        }
+        parseIndex += end - begin;
+
+        switch (result.type) {
+        case NUMBER_INTEGER:
+            handler->integer(result.integer);
+            break;
+        case NUMBER_UNSIGNED:
+            handler->unsignedInteger(result.uinteger);
+            break;
+        default:
+            handler->number(result.floating);
+            break;
         }
+        return true;
+    }
 
-        bool result;
-        if (currentString.str().compare("true") == 0) {
-            result = true;
-        } else if (currentString.str().compare("false") == 0) {
-            result = false;
-        } else {
-            throw ParseException (lineNumber);
-        } 
-        
-        store(result);
+    /**
+     * true | false 
+     */
+    bool Parser::parseBoolean() {
+        bool value = peek() == 't';
+        if (!(value ? parseLiteral("true", 4) : parseLiteral("false", 5))) {
+            return false;
+        }
+        handler->boolean(value);
+        return true;
     }
 
     /**
      * "..."
      */
-    void Parser::parseString() throw(std::exception) {
-        // Reset string buffer
-        currentString.str("");
-        consume(); // '"'
-        while (peek() != ESC_QUOTATION_MARK) {
-            // String contains an escaped character?
-            if (peek() == ESC_REVERSE_SOLIUDS) {
-                escapeChar();
-            } else {
-                currentString << next();
-            }
+    bool Parser::parseString() {
+        if (!readString(currentString)) {
+            return false;
         }
-
-        consume(); // '"'
-        store(currentString.str());
+        handler->string(currentString);
+        return true;
     }
 
     /**
-     * \...
+     * Read a quoted string into buffer. Raw control characters
+     * are not allowed in JSON strings.
      */
-    void Parser::escapeChar() throw(std::exception) {
-      consume(); // REVERSE_SOLIDUS
-      // Decide which escape character follows
-      switch(peek()) {
-          case ESC_BACKSPACE:
-              consume();
-              currentString << (char) 8;
-              break;
-          case ESC_HORIZONTAL_TAB:
-              consume();
-              currentString << (char) 9;
-              break;
-          case ESC_NEWLINE:
-              consume();
-              currentString << (char) 10;
-              break;
-          case ESC_FORMFEED:
-              consume();
-              currentString << (char) 12;
-              break;
-          case ESC_CARRET:
-              consume();
-              currentString << (char) 13;
-              break;
-          case ESC_QUOTATION_MARK:
-          case ESC_REVERSE_SOLIUDS:
-          case ESC_SOLIDUS:
-              currentString << next();
-              break;
-          case ESC_UNICODE:
-              // a \u occured
-              // read the following sequence and insert it's
-              // unicode representation into the string.
-              readUTF8Escape();            
-              break;
-          default:
-              throw ParseException(lineNumber);
-      }
-    }
-
-    void Parser::readUTF8Escape() throw(std::exception) {
-        consume(); // u
-        int codePoint = -1;
-        std::string tmp(4,32);
-        std::stringstream ss;
-        std::string result;
-        wideString str32;
-        
-        for (unsigned int index=0;index<tmp.length();index++) {
-            if (!hasNext() || !validHexDigit(peek())) {
-              throw ParseException(lineNumber);
+    bool Parser::readString(std::string& buffer) {
+        const char* end = source + length;
+        const char* error;
+        const char* current = strings::unescape(
+            source + parseIndex + 1, end, buffer, error);
+
+        if (!current) {
+            uint32_t codePoint;
+            if (error == end) {
+                return fail(PARSE_UNEXPECTED_END, length);
+            } else if (strings::invalidCodePoint(error, end, codePoint)) {
+                return fail(PARSE_INVALID_CODE_POINT, error - source);
             }
-            
-            tmp[index] = next();
+            return fail(PARSE_SYNTAX_ERROR, error - source);
         }
-        
-        ss << std::hex << tmp;
-        ss >> codePoint;
-        str32.push_back(codePoint);
-        utf8::utf32to8(str32.begin(), str32.end(), std::back_inserter(result));
-        currentString << result;
+        parseIndex = current - source;
+        return true;
     }
 
     /**
-     * [...]
+     * The whole input must be a single value
      */
-    void Parser::parseArray() throw(std::exception) {
-        consume(); // '['
-                
-        objectStack.push(&store(Array {}));
-        clearWhitespace();
+    bool Parser::parseDocument(Handler& handler, const char *source,
+        size_t length) {
+        reset();
+        this->source = source;
+        this->length = length;
+        this->handler = &handler;
 
-        // Empty array?
-        if (peek() == ']') {
-            consume(); // ']'
-            objectStack.pop();
-            return;
+        if (!parseValue()) {
+            return false;
         }
-                
-        while(hasNext()) {                        
-            parseValue();
-            clearWhitespace();
-            
-            if (peek() != ',') {
-                break;
-            } else {
-                consume(); // ','
-            }
-        }
-        
-        if (peek() != ']') {
-            throw ParseException(lineNumber);
-        } else {
-            consume(); // ']'
+        clearWhitespace();
+        if (parseIndex < length) {
+            return fail(PARSE_UNEXPECTED_CHARACTERS, parseIndex);
         }
-                
-        objectStack.pop();
+        return true;
     }
 
     /**
      * Entry points
      */
-    void Parser::parse(Value& value, const std::string &source) 
-    throw(std::exception) {
-        reset();
-        if (source.length() > 0) {
+    void Parser::parse(Handler& handler, const char *source, size_t length) {
+        if (length > 0 && !parseDocument(handler, source, length)) {
+            raise();
+        }
+    }
+
+    void Parser::parse(Handler& handler, const std::string &source) {
+        parse(handler, source.data(), source.length());
+    }
+
+    void Parser::parse(Handler& handler, const char *source) {
+        parse(handler, source, strlen(source));
+    }
+
+    void Parser::parse(Value& value, const char *source, size_t length) {
+        if (length > 0) {
             value = null;
-            this->source = source;
-            objectStack.push(&value);
-            parseValue();
-            clearWhitespace();
-            if (parseIndex < source.length()) {
-                throw UnexpectedCharactersException();
-            }
+            builder.reset(value);
+            parse(builder, source, length);
+        }
+    }
+
+    void Parser::parse(Value& value, const std::string &source) {
+        parse(value, source.data(), source.length());
+    }
+
+    void Parser::parse(Value& value, const char *source) {
+        parse(value, source, strlen(source));
+    }
+
+    void Parser::parse(Document& document, const char *source, size_t length) {
+        document.reset();
+        if (length > 0) {
+            builder.reset(document.getRoot(), document.getKeyTable());
+            parse(builder, source, length);
+        }
+    }
+
+    void Parser::parse(Document& document, const std::string &source) {
+        parse(document, source.data(), source.length());
+    }
+
+    void Parser::parse(Document& document, const char *source) {
+        parse(document, source, strlen(source));
+    }
+
+    ParseError Parser::tryParse(Handler& handler, const char *source,
+        size_t length) {
+        if (length > 0) {
+            parseDocument(handler, source, length);
+            return error;
+        }
+        return ParseError();
+    }
+
+    ParseError Parser::tryParse(Handler& handler, const std::string &source) {
+        return tryParse(handler, source.data(), source.length());
+    }
+
+    ParseError Parser::tryParse(Handler& handler, const char *source) {
+        return tryParse(handler, source, strlen(source));
+    }
+
+    ParseError Parser::tryParse(Value& value, const char *source,
+        size_t length) {
+        if (length > 0) {
+            value = null;
+            builder.reset(value);
+            return tryParse(builder, source, length);
+        }
+        return ParseError();
+    }
+
+    ParseError Parser::tryParse(Value& value, const std::string &source) {
+        return tryParse(value, source.data(), source.length());
+    }
+
+    ParseError Parser::tryParse(Value& value, const char *source) {
+        return tryParse(value, source, strlen(source));
+    }
+
+    ParseError Parser::tryParse(Document& document, const char *source,
+        size_t length) {
+        document.reset();
+        if (length > 0) {
+            builder.reset(document.getRoot(), document.getKeyTable());
+            return tryParse(builder, source, length);
         }
+        return ParseError();
+    }
+
+    ParseError Parser::tryParse(Document& document,
+        const std::string &source) {
+        return tryParse(document, source.data(), source.length());
+    }
+
+    ParseError Parser::tryParse(Document& document, const char *source) {
+        return tryParse(document, source, strlen(source));
+    }
+
+    void Parser::parseFile(Value& value, const char *path) {
+        MappedFile file(path);
+        parse(value, file.data(), file.size());
     }
 
-    void Parser::parse(Value& value, const char *source) 
-    throw(std::exception) {
-        std::string _source(source);
-        parse(value, _source);
+    void Parser::parseFile(Handler& handler, const char *path) {
+        MappedFile file(path);
+        parse(handler, file.data(), file.size());
     }
 }
 
@@ -8,53 +8,53 @@ namespace JSON {
   
     class PrettyPrinter : public Printer {
     public:
-        PrettyPrinter(unsigned int indent=default_indent)
-            : indentDepth(indent),
+        PrettyPrinter(unsigned int indent=default_indent,
+            Escaping escaping=ESCAPE_MINIMAL)
+            : Printer(escaping),
+              indentDepth(indent),
               currentIndent(0) { }
     private:
-        void printArray(const Value& value, std::ostringstream &out);
-        void printObject(const Value& value, std::ostringstream &out);
-        void printIndent(std::ostringstream& out);
+        void printArray(const Value& value, Sink &out);
+        void printObject(const Value& value, Sink &out);
+        void printIndent(Sink& out);
 
         unsigned int indentDepth;
         unsigned int currentIndent;
     };
 
-    void PrettyPrinter::printIndent(std::ostringstream &out) {
+    void PrettyPrinter::printIndent(Sink &out) {
         for (unsigned int i = 0; i < currentIndent; ++i) {
-            out << " ";
+            out.put(' ');
         }
     }
 
-    void PrettyPrinter::printArray(const Value& value, std::ostringstream &out) {
+    void PrettyPrinter::printArray(const Value& value, Sink &out) {
         bool firstItem = true;
-        out << "[";
-        for (auto item : value.as<Array>()) {
-            if (!firstItem) { out << ", "; }
+        out.put('[');
+        for (const auto& item : value.asArray()) {
+            if (!firstItem) { out.write(", ", 2); }
             dispatchType(item, out);
             firstItem = false;
         }
-        out << "]";
+        out.put(']');
     }
 
-    void PrettyPrinter::printObject(const Value& value, std::ostringstream &out) {
+    void PrettyPrinter::printObject(const Value& value, Sink &out) {
         currentIndent += indentDepth;
-        out << "{\n";
+        out.write("{\n", 2);
         bool firstLine = true;
-        for (auto pair : value.as<Object>()) {
-            if (!firstLine) { out << ",\n"; }
+        for (const auto& pair : value.asObject()) {
+            if (!firstLine) { out.write(",\n", 2); }
             printIndent(out);
-            out << "\"";
-            out << pair.first;
-            out << "\"";
-            out << ": ";
+            printString(pair.first.data(), pair.first.length(), out);
+            out.write(": ", 2);
             dispatchType(pair.second, out);
             firstLine = false;
         }
         currentIndent -= indentDepth;
-        out << "\n";
+        out.put('\n');
         printIndent(out);
-        out << "}";
+        out.put('}');
     }
 }
 
@@ -1,31 +1,46 @@
 #ifndef PRINTER_H
 #define PRINTER_H
 
-#include <sstream>
+#include <ostream>
+#include <string>
+
+#include "Sink.hpp"
+#include "Strings.hpp"
 
 namespace JSON {
     class Printer {
     public:
-        void print(const Value val, std::ostringstream& out);
-        std::string print(const Value val);
+        Printer(Escaping escaping = ESCAPE_MINIMAL) : escaping(escaping) { }
+
+        // Write to a sink, which is flushed at the end
+        void print(const Value& val, Sink& out);
+
+        // Write to a stream or return a string
+        void print(const Value& val, std::ostream& out);
+        std::string print(const Value& val);
 
         virtual ~Printer() { }
 
     protected:
-        void dispatchType(const Value &val, std::ostringstream &out);
-        void printNumber(const Value &val, std::ostringstream &out);
-        void printBoolean(const Value &val, std::ostringstream &out);
-        void printString(const Value &val, std::ostringstream &out);
+        void dispatchType(const Value &val, Sink &out);
+        void printNumber(const Value &val, Sink &out);
+        void printBoolean(const Value &val, Sink &out);
+        void printString(const Value &val, Sink &out);
+
+        // Quoted and escaped string or key
+        void printString(const char * string, size_t length, Sink &out);
 
         /**
           * Allow to overwrite the formatting of Object and
           * Array for Pretty Printing.
           */
-        virtual void printObject(const Value &val, std::ostringstream &out);
-        virtual void printArray(const Value &val, std::ostringstream &out);
+        virtual void printObject(const Value &val, Sink &out);
+        virtual void printArray(const Value &val, Sink &out);
+
+        Escaping escaping;
     };
 
-    void Printer::dispatchType(const Value &val, std::ostringstream &out) {    
+    void Printer::dispatchType(const Value &val, Sink &out) {    
         switch (val.getType()) {
         case JSON_OBJECT:
             printObject(val, out);
@@ -43,59 +58,87 @@ namespace JSON {
             printString(val, out);
             break;
         case JSON_NULL:
-            out << typenames[JSON_NULL];
+            out.write("null", 4);
             break;
         }
     }
 
-    void Printer::printObject(const Value &val, std::ostringstream &out) {
+    void Printer::printObject(const Value &val, Sink &out) {
         bool firstLine = true;
-        out << "{";
-        for (auto pair : val.as<Object>()) {
-            if (!firstLine) { out << ","; }
-            out << "\"";
-            out << pair.first;
-            out << "\"";
-            out << ":";
+        out.put('{');
+        for (const auto& pair : val.asObject()) {
+            if (!firstLine) { out.put(','); }
+            printString(pair.first.data(), pair.first.length(), out);
+            out.put(':');
             dispatchType(pair.second, out);
             firstLine = false;
         }
-        out << "}";
+        out.put('}');
     }
 
-    void Printer::printArray(const Value &val, std::ostringstream &out) {
+    void Printer::printArray(const Value &val, Sink &out) {
         bool firstItem = true;
-        out << "[";
-        for (auto item : val.as<Array>()) {
-            if (!firstItem) { out << ","; }
+        out.put('[');
+        for (const auto& item : val.asArray()) {
+            if (!firstItem) { out.put(','); }
             dispatchType(item, out);
             firstItem = false;
         }
-        out << "]";
+        out.put(']');
     }
 
-    void Printer::printNumber(const Value &val, std::ostringstream &out) {
-        out << val.as<double>();
+    void Printer::printNumber(const Value &val, Sink &out) {
+        char buffer[number::FORMAT_BUFFER_SIZE];
+        char *end;
+        switch (val.getNumberType()) {
+        case NUMBER_INTEGER:
+            end = number::format(val.as<int64_t>(), buffer);
+            break;
+        case NUMBER_UNSIGNED:
+            end = number::format(val.as<uint64_t>(), buffer);
+            break;
+        default:
+            end = number::format(val.as<double>(), buffer);
+            break;
+        }
+        out.write(buffer, end - buffer);
     }
 
-    void Printer::printBoolean(const Value &val, std::ostringstream &out) {
-        out << (val.as<bool>() ? "true" : "false");
+    void Printer::printBoolean(const Value &val, Sink &out) {
+        if (val.as<bool>()) {
+            out.write("true", 4);
+        } else {
+            out.write("false", 5);
+        }
     }
 
-    void Printer::printString(const Value &val, std::ostringstream &out) {
-        out << "\"";
-        out << val.as<std::string>();
-        out << "\"";
+    void Printer::printString(const Value &val, Sink &out) {
+        const String& string = val.asString();
+        printString(string.data(), string.length(), out);
     }
 
-    void Printer::print(const Value val, std::ostringstream &out) {
-        dispatchType(val, out);
+    void Printer::printString(const char* string, size_t length,
+        Sink &out) {
+        out.put('"');
+        strings::escape(string, string + length, out, escaping);
+        out.put('"');
     }
 
-    std::string Printer::print(const Value val) {
-        std::ostringstream out;
+    void Printer::print(const Value& val, Sink &out) {
         dispatchType(val, out);
-        return out.str();
+        out.flush();
+    }
+
+    void Printer::print(const Value& val, std::ostream &out) {
+        StreamSink sink(out);
+        print(val, sink);
+    }
+
+    std::string Printer::print(const Value& val) {
+        std::string out;
+        StringSink sink(out);
+        print(val, sink);
+        return out;
     }
 }
 
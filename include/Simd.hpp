@@ -0,0 +1,426 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <stdint.h>
+
+/**
+ * Vectorized scanning kernels used by the parsers and printers.
+ *
+ * SSE2 is part of every x86-64 CPU and used unconditionally there,
+ * AVX2 is selected at runtime if the CPU supports it. Everything else
+ * uses the scalar versions. Define ELSON_SIMD_SCALAR to force the
+ * scalar path (e.g. for testing).
+ */
+#if !defined(ELSON_SIMD_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+#   define ELSON_SIMD_SSE2
+#   include <emmintrin.h>
+#   if defined(__GNUC__) || defined(__clang__)
+#       define ELSON_SIMD_AVX2
+#       include <immintrin.h>
+#   endif
+#endif
+
+namespace JSON { namespace simd {
+    // JSON whitespace
+    inline bool isWhitespace(char code) {
+        return code == ' ' || code == '\n' || code == '\r' || code == '\t';
+    }
+
+    // Structural operators
+    inline bool isOperator(char code) {
+        return code == '{' || code == '}' || code == '[' || code == ']'
+            || code == ':' || code == ',';
+    }
+
+    // Character classes of a 64 byte block, one bit per byte
+    struct BlockMasks {
+        uint64_t quote;
+        uint64_t backslash;
+        uint64_t op;
+        uint64_t whitespace;
+    };
+
+    // Characters that end a run of plain string content
+    inline bool isStringSpecial(char code) {
+        return code == '"' || code == '\\' || (unsigned char) code < 0x20;
+    }
+
+    inline int firstBit(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctz(mask);
+#else
+        int index = 0;
+        while (!(mask & 1)) {
+            mask >>= 1;
+            index++;
+        }
+        return index;
+#endif
+    }
+
+    inline int firstBit64(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(mask);
+#else
+        int index = 0;
+        while (!(mask & 1)) {
+            mask >>= 1;
+            index++;
+        }
+        return index;
+#endif
+    }
+
+    /**
+     * Scalar kernels
+     */
+    inline const char* findStringSpecialScalar(
+        const char* p, const char* end) {
+        while (p != end && !isStringSpecial(*p)) {
+            p++;
+        }
+        return p;
+    }
+
+    inline const char* findStringSpecialOrNonAsciiScalar(
+        const char* p, const char* end) {
+        while (p != end && !isStringSpecial(*p)
+            && (unsigned char) *p < 0x80) {
+            p++;
+        }
+        return p;
+    }
+
+    inline const char* skipWhitespaceScalar(
+        const char* p, const char* end) {
+        while (p != end && isWhitespace(*p)) {
+            p++;
+        }
+        return p;
+    }
+
+    inline size_t countNewlinesScalar(const char* p, const char* end) {
+        size_t newlines = 0;
+        for (; p != end; p++) {
+            newlines += *p == '\n';
+        }
+        return newlines;
+    }
+
+    inline void classifyScalar(const char* p, BlockMasks& masks) {
+        masks.quote = masks.backslash = masks.op = masks.whitespace = 0;
+        for (int index = 0; index < 64; index++) {
+            uint64_t bit = 1ULL << index;
+            char code = p[index];
+            if (code == '"') {
+                masks.quote |= bit;
+            } else if (code == '\\') {
+                masks.backslash |= bit;
+            } else if (isOperator(code)) {
+                masks.op |= bit;
+            } else if (isWhitespace(code)) {
+                masks.whitespace |= bit;
+            }
+        }
+    }
+
+#ifdef ELSON_SIMD_SSE2
+    /**
+     * SSE2 kernels, 16 bytes at a time
+     */
+    inline uint32_t stringSpecialMask(__m128i chunk) {
+        __m128i quote = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+        __m128i backslash = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'));
+        // Unsigned chunk <= 0x1F
+        __m128i control = _mm_cmpeq_epi8(
+            _mm_min_epu8(chunk, _mm_set1_epi8(0x1F)), chunk);
+        return (uint32_t) _mm_movemask_epi8(
+            _mm_or_si128(_mm_or_si128(quote, backslash), control));
+    }
+
+    inline const char* findStringSpecialSse2(
+        const char* p, const char* end) {
+        for (; end - p >= 16; p += 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+            uint32_t mask = stringSpecialMask(chunk);
+            if (mask) {
+                return p + firstBit(mask);
+            }
+        }
+        return findStringSpecialScalar(p, end);
+    }
+
+    inline const char* findStringSpecialOrNonAsciiSse2(
+        const char* p, const char* end) {
+        for (; end - p >= 16; p += 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+            // The sign bits mark bytes beyond ASCII
+            uint32_t mask = stringSpecialMask(chunk)
+                | (uint32_t) _mm_movemask_epi8(chunk);
+            if (mask) {
+                return p + firstBit(mask);
+            }
+        }
+        return findStringSpecialOrNonAsciiScalar(p, end);
+    }
+
+    inline const char* skipWhitespaceSse2(
+        const char* p, const char* end) {
+        for (; end - p >= 16; p += 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+            __m128i space = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')),
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+            uint32_t other = (uint32_t) _mm_movemask_epi8(space) ^ 0xFFFF;
+            if (other) {
+                return p + firstBit(other);
+            }
+        }
+        return skipWhitespaceScalar(p, end);
+    }
+
+    inline size_t countNewlinesSse2(const char* p, const char* end) {
+        __m128i zero = _mm_setzero_si128();
+        __m128i total = zero;
+        while (end - p >= 16) {
+            // Count in bytes, up to 255 blocks before they overflow
+            size_t blocks = (size_t) (end - p) / 16;
+            if (blocks > 255) {
+                blocks = 255;
+            }
+            __m128i counts = zero;
+            for (; blocks > 0; blocks--, p += 16) {
+                __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+                counts = _mm_sub_epi8(counts,
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+            }
+            total = _mm_add_epi64(total, _mm_sad_epu8(counts, zero));
+        }
+        // Both 64 bit halves, _mm_cvtsi128_si64 is not on 32 bit x86
+        uint64_t sums[2];
+        _mm_storeu_si128((__m128i*) sums, total);
+        return (size_t) (sums[0] + sums[1]) + countNewlinesScalar(p, end);
+    }
+
+    inline void classifySse2(const char* p, BlockMasks& masks) {
+        masks.quote = masks.backslash = masks.op = masks.whitespace = 0;
+        for (int index = 0; index < 4; index++) {
+            __m128i chunk = _mm_loadu_si128((const __m128i*) (p + 16 * index));
+            // '[' and ']' only differ from '{' and '}' in bit 5
+            __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+            __m128i op = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(lower, _mm_set1_epi8('{')),
+                    _mm_cmpeq_epi8(lower, _mm_set1_epi8('}'))),
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')),
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))));
+            __m128i space = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')),
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+
+            int shift = 16 * index;
+            masks.quote |= (uint64_t) (uint32_t) _mm_movemask_epi8(
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))) << shift;
+            masks.backslash |= (uint64_t) (uint32_t) _mm_movemask_epi8(
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))) << shift;
+            masks.op |= (uint64_t) (uint32_t) _mm_movemask_epi8(op) << shift;
+            masks.whitespace |=
+                (uint64_t) (uint32_t) _mm_movemask_epi8(space) << shift;
+        }
+    }
+#endif
+
+#ifdef ELSON_SIMD_AVX2
+    /**
+     * AVX2 kernels, 32 bytes at a time. Only called after a
+     * runtime check.
+     */
+    __attribute__((target("avx2")))
+    inline const char* findStringSpecialAvx2(
+        const char* p, const char* end) {
+        for (; end - p >= 32; p += 32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i*) p);
+            __m256i quote = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+            __m256i backslash =
+                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'));
+            __m256i control = _mm256_cmpeq_epi8(
+                _mm256_min_epu8(chunk, _mm256_set1_epi8(0x1F)), chunk);
+            uint32_t mask = (uint32_t) _mm256_movemask_epi8(
+                _mm256_or_si256(_mm256_or_si256(quote, backslash), control));
+            if (mask) {
+                return p + firstBit(mask);
+            }
+        }
+        return findStringSpecialSse2(p, end);
+    }
+
+    __attribute__((target("avx2")))
+    inline const char* findStringSpecialOrNonAsciiAvx2(
+        const char* p, const char* end) {
+        for (; end - p >= 32; p += 32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i*) p);
+            __m256i quote = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'));
+            __m256i backslash =
+                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'));
+            __m256i control = _mm256_cmpeq_epi8(
+                _mm256_min_epu8(chunk, _mm256_set1_epi8(0x1F)), chunk);
+            uint32_t mask = (uint32_t) _mm256_movemask_epi8(
+                _mm256_or_si256(_mm256_or_si256(quote, backslash), control))
+                | (uint32_t) _mm256_movemask_epi8(chunk);
+            if (mask) {
+                return p + firstBit(mask);
+            }
+        }
+        return findStringSpecialOrNonAsciiSse2(p, end);
+    }
+
+    __attribute__((target("avx2")))
+    inline const char* skipWhitespaceAvx2(
+        const char* p, const char* end) {
+        for (; end - p >= 32; p += 32) {
+            __m256i chunk = _mm256_loadu_si256((const __m256i*) p);
+            __m256i space = _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')),
+                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')),
+                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r'))));
+            uint32_t other = ~(uint32_t) _mm256_movemask_epi8(space);
+            if (other) {
+                return p + firstBit(other);
+            }
+        }
+        return skipWhitespaceSse2(p, end);
+    }
+
+    __attribute__((target("avx2")))
+    inline void classifyAvx2(const char* p, BlockMasks& masks) {
+        masks.quote = masks.backslash = masks.op = masks.whitespace = 0;
+        for (int index = 0; index < 2; index++) {
+            __m256i chunk =
+                _mm256_loadu_si256((const __m256i*) (p + 32 * index));
+            __m256i lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+            __m256i op = _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')),
+                    _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}'))),
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')),
+                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(','))));
+            __m256i space = _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')),
+                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')),
+                    _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r'))));
+
+            int shift = 32 * index;
+            masks.quote |= (uint64_t) (uint32_t) _mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))) << shift;
+            masks.backslash |= (uint64_t) (uint32_t) _mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))) << shift;
+            masks.op |=
+                (uint64_t) (uint32_t) _mm256_movemask_epi8(op) << shift;
+            masks.whitespace |=
+                (uint64_t) (uint32_t) _mm256_movemask_epi8(space) << shift;
+        }
+    }
+
+    inline bool hasAvx2() {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+#endif
+
+    /**
+     * Dispatching entry points
+     */
+
+    // Find the first '"', '\' or control character in [p, end)
+    inline const char* findStringSpecial(const char* p, const char* end) {
+#if defined(ELSON_SIMD_AVX2)
+        if (hasAvx2()) {
+            return findStringSpecialAvx2(p, end);
+        }
+#endif
+#if defined(ELSON_SIMD_SSE2)
+        return findStringSpecialSse2(p, end);
+#else
+        return findStringSpecialScalar(p, end);
+#endif
+    }
+
+    // Same, but also stop at bytes beyond ASCII
+    inline const char* findStringSpecialOrNonAscii(
+        const char* p, const char* end) {
+#if defined(ELSON_SIMD_AVX2)
+        if (hasAvx2()) {
+            return findStringSpecialOrNonAsciiAvx2(p, end);
+        }
+#endif
+#if defined(ELSON_SIMD_SSE2)
+        return findStringSpecialOrNonAsciiSse2(p, end);
+#else
+        return findStringSpecialOrNonAsciiScalar(p, end);
+#endif
+    }
+
+    // Classify the 64 bytes at p
+    inline void classify(const char* p, BlockMasks& masks) {
+#if defined(ELSON_SIMD_AVX2)
+        if (hasAvx2()) {
+            classifyAvx2(p, masks);
+            return;
+        }
+#endif
+#if defined(ELSON_SIMD_SSE2)
+        classifySse2(p, masks);
+#else
+        classifyScalar(p, masks);
+#endif
+    }
+
+    // Skip whitespace in [p, end)
+    inline const char* skipWhitespace(const char* p, const char* end) {
+        // Most runs in compact JSON are empty or a single space,
+        // avoid the vector setup for those.
+        if (p == end || !isWhitespace(*p)) {
+            return p;
+        }
+        if (end - p < 2 || !isWhitespace(p[1])) {
+            return p + 1;
+        }
+#if defined(ELSON_SIMD_AVX2)
+        if (hasAvx2()) {
+            return skipWhitespaceAvx2(p, end);
+        }
+#endif
+#if defined(ELSON_SIMD_SSE2)
+        return skipWhitespaceSse2(p, end);
+#else
+        return skipWhitespaceScalar(p, end);
+#endif
+    }
+
+    // Number of newlines in [p, end), for error positions
+    inline size_t countNewlines(const char* p, const char* end) {
+#if defined(ELSON_SIMD_SSE2)
+        return countNewlinesSse2(p, end);
+#else
+        return countNewlinesScalar(p, end);
+#endif
+    }
+}   }
+
+#endif // SIMD_HPP
@@ -0,0 +1,288 @@
+#ifndef SINK_H
+#define SINK_H
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
+
+#include "Exceptions.hpp"
+
+namespace JSON {
+    /**
+     * Destination of printed JSON. Writes are copied into a window of
+     * memory provided by the sink without a virtual call; only when
+     * the window is full does the sink get to pass the data on (and
+     * provide a new window).
+     */
+    class Sink {
+        public:
+            Sink() : current(0), end(0) { }
+
+            virtual ~Sink() { }
+
+            void write(const char * data, size_t length) {
+                if (length < (size_t) (end - current)) {
+                    memcpy(current, data, length);
+                    current += length;
+                } else {
+                    overflow(data, length);
+                }
+            }
+
+            void write(const std::string& data) {
+                write(data.data(), data.length());
+            }
+
+            void put(char character) {
+                if (current != end) {
+                    *current++ = character;
+                } else {
+                    overflow(&character, 1);
+                }
+            }
+
+            // Pass on everything written so far
+            virtual void flush() { }
+
+        protected:
+            // Called for data that does not fit into the window.
+            // Takes the data and may set up a new window.
+            virtual void overflow(const char * data, size_t length) = 0;
+
+            // Free part of the window
+            char * current;
+            char * end;
+    };
+
+    /**
+     * Appends to a std::string. The string is used as the buffer so
+     * its contents are only complete after flush().
+     */
+    class StringSink : public Sink {
+        public:
+            StringSink(std::string& target) : target(target) { }
+
+            ~StringSink() {
+                flush();
+            }
+
+            void flush() {
+                if (current) {
+                    target.resize(current - &target[0]);
+                    current = end = 0;
+                }
+            }
+
+        protected:
+            void overflow(const char * data, size_t size) {
+                size_t used = current
+                    ? current - &target[0] : target.length();
+                size_t capacity = target.capacity() > 64
+                    ? target.capacity() : 64;
+                while (capacity < used + size) {
+                    capacity *= 2;
+                }
+                target.resize(capacity);
+
+                memcpy(&target[0] + used, data, size);
+                current = &target[0] + used + size;
+                end = &target[0] + target.length();
+            }
+
+        private:
+            std::string& target;
+    };
+
+    /**
+     * Writes into a caller provided buffer without allocating.
+     * Output that does not fit is dropped (but counted) and the
+     * buffer is not null terminated.
+     */
+    class BufferSink : public Sink {
+        public:
+            BufferSink(char * buffer, size_t capacity)
+            : buffer(buffer), dropped(0) {
+                current = buffer;
+                end = buffer + capacity;
+            }
+
+            // Bytes in the buffer
+            size_t size() const {
+                return current - buffer;
+            }
+
+            // Bytes the whole output would need
+            size_t required() const {
+                return size() + dropped;
+            }
+
+            bool truncated() const {
+                return dropped > 0;
+            }
+
+        protected:
+            void overflow(const char * data, size_t length) {
+                size_t fits = end - current;
+                memcpy(current, data, fits);
+                current += fits;
+                dropped += length - fits;
+            }
+
+        private:
+            char * buffer;
+            size_t dropped;
+    };
+
+    /**
+     * Collects small writes in a buffer and passes them on in
+     * large blocks.
+     */
+    class BufferedSink : public Sink {
+        public:
+            BufferedSink() {
+                current = buffer;
+                end = buffer + sizeof(buffer);
+            }
+
+            void flush() {
+                if (current != buffer) {
+                    size_t length = current - buffer;
+                    current = buffer;
+                    output(buffer, length);
+                }
+            }
+
+        protected:
+            // Receives the buffered output
+            virtual void output(const char * data, size_t length) = 0;
+
+            void overflow(const char * data, size_t length) {
+                flush();
+                if (length >= sizeof(buffer)) {
+                    output(data, length);
+                } else {
+                    memcpy(current, data, length);
+                    current += length;
+                }
+            }
+
+        private:
+            char buffer[8 * 1024];
+    };
+
+    /**
+     * Writes to a FILE or a file descriptor, throwing a
+     * WriteException on errors. Neither is closed, and a FILE
+     * buffers the output as usual until it is flushed itself.
+     */
+    class FileSink : public BufferedSink {
+        public:
+            FileSink(FILE * file) : file(file), fd(-1) { }
+            FileSink(int fd) : file(0), fd(fd) { }
+
+            ~FileSink() {
+#ifdef ELSON_EXCEPTIONS
+                try {
+                    flush();
+                } catch (const WriteException&) {
+                    // Call flush() to see errors
+                }
+#else
+                flush();
+#endif
+            }
+
+        protected:
+            void output(const char * data, size_t length);
+
+        private:
+            FILE * file;
+            int fd;
+    };
+
+    void FileSink::output(const char* data, size_t length) {
+        if (file) {
+            if (fwrite(data, 1, length, file) != length) {
+                ELSON_THROW(WriteException(errno));
+            }
+            return;
+        }
+
+        while (length > 0) {
+#if defined(_WIN32)
+            int written = _write(fd, data, (unsigned int) length);
+#else
+            ssize_t written = ::write(fd, data, length);
+#endif
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ELSON_THROW(WriteException(errno));
+            }
+            data += written;
+            length -= written;
+        }
+    }
+
+    /**
+     * Passes the output to a function in blocks
+     */
+    class CallbackSink : public BufferedSink {
+        public:
+            typedef std::function<void(const char *, size_t)> Callback;
+
+            CallbackSink(const Callback& callback) : callback(callback) { }
+
+            ~CallbackSink() {
+#ifdef ELSON_EXCEPTIONS
+                try {
+                    flush();
+                } catch (...) {
+                    // Call flush() to see errors
+                }
+#else
+                flush();
+#endif
+            }
+
+        protected:
+            void output(const char * data, size_t length) {
+                callback(data, length);
+            }
+
+        private:
+            Callback callback;
+    };
+
+    /**
+     * Writes to a std::ostream
+     */
+    class StreamSink : public BufferedSink {
+        public:
+            StreamSink(std::ostream& stream) : stream(stream) { }
+
+            ~StreamSink() {
+                flush();
+            }
+
+        protected:
+            void output(const char * data, size_t length) {
+                stream.write(data, length);
+            }
+
+        private:
+            std::ostream& stream;
+    };
+}
+
+#endif // SINK_H
@@ -0,0 +1,585 @@
+#ifndef STREAMPARSER_H
+#define STREAMPARSER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+#include "Handler.hpp"
+#include "Simd.hpp"
+#include "Strings.hpp"
+#include "Value.hpp"
+
+namespace JSON {
+    /**
+     * Push parser for input that arrives in pieces. Every call to
+     * feed() reports as much of the document to the handler as the
+     * data allows, chunks may end anywhere (even within a string or
+     * an escape sequence). finish() completes the document.
+     *
+     * All state lives in the parser itself instead of the call
+     * stack. Accepts the same documents (up to the same nesting depth)
+     * and raises the same exceptions as JSON::Parser. After an
+     * exception call reset() before parsing again.
+     */
+    class StreamParser {
+        public:
+            StreamParser(Handler& handler)
+            : target(0), handler(&handler), maxDepth(default_max_depth) {
+                reset();
+            }
+
+            // Build into value, which is set to null as soon as
+            // the first data arrives.
+            StreamParser(Value& value)
+            : target(&value), handler(&builder),
+              maxDepth(default_max_depth) {
+                reset();
+            }
+
+            // Arrays and objects allowed within each other
+            size_t getMaxDepth() const {
+                return maxDepth;
+            }
+
+            void setMaxDepth(size_t depth) {
+                maxDepth = depth;
+            }
+
+            void feed(const char * data, size_t length);
+            void feed(const std::string& data);
+
+            // Completes the document and prepares the parser for the
+            // next one. Does nothing if no data was fed at all.
+            void finish();
+
+            // Discard any partial document
+            void reset();
+
+        private:
+            StreamParser(const StreamParser&);
+            StreamParser& operator=(const StreamParser&);
+
+            enum State {
+                // Between tokens
+                EXPECT_VALUE,
+                EXPECT_FIRST_VALUE,     // after '['
+                EXPECT_FIRST_KEY,       // after '{'
+                EXPECT_KEY,             // after ',' within an object
+                EXPECT_COLON,
+                EXPECT_NEXT,            // after a value within a container
+                DONE,                   // after the root value
+
+                // Within a token
+                IN_STRING,
+                IN_ESCAPE,
+                IN_UNICODE,
+                IN_LITERAL,
+                IN_NUMBER
+            };
+
+            // Characters that may continue a number. Whether they
+            // form a valid one is decided by number::scan.
+            static bool isNumberCharacter(char code) {
+                return (code >= '0' && code <= '9') || code == '-'
+                    || code == '+' || code == '.' || code == 'e'
+                    || code == 'E';
+            }
+
+            // A value is complete, continue with its container
+            void valueDone() {
+                state = containers.empty() ? DONE : EXPECT_NEXT;
+            }
+
+            // Position of the byte at p in the current chunk, or at
+            // offset from the start of the document
+            ParseError locate(ParseErrorCode code, const char* p) const;
+            ParseError locate(ParseErrorCode code, size_t offset) const;
+
+            // A lead surrogate must be followed by \u and a trail
+            // surrogate, like strings::readUTF8Escape requires
+            void invalidLead() const {
+                if (leadSurrogate) {
+                    ELSON_THROW(InvalidCodePointException(leadSurrogate,
+                        locate(PARSE_INVALID_CODE_POINT, leadStart)));
+                }
+            }
+
+            // Before an array or object is opened at p
+            void checkDepth(const char* p) const {
+                if (containers.size() >= maxDepth) {
+                    ELSON_THROW(NestingDepthException(maxDepth,
+                        locate(PARSE_TOO_DEEP, p)));
+                }
+            }
+
+            const char* readToken(const char* p, const char* end);
+            const char* startValue(const char* p, const char* end);
+            const char* readString(const char* p, const char* end);
+            const char* readEscape(const char* p, const char* end);
+            const char* readLiteral(const char* p, const char* end);
+            const char* readNumber(const char* p, const char* end);
+            void emitNumber(const char* begin, const char* end);
+
+            // Build target through builder or report to a user handler
+            Value * target;
+            ValueBuilder builder;
+            Handler * handler;
+
+            State state;
+            bool started;
+
+            // The chunk being parsed. Lines are counted once a chunk
+            // is done, for error messages only.
+            const char * chunk;
+            size_t consumed;            // bytes before the chunk
+            size_t lines;               // newlines before the chunk
+            size_t lineStart;           // offset of the current line
+
+            // Open arrays ('[') and objects ('{')
+            std::vector<char> containers;
+            size_t maxDepth;
+
+            // Partial tokens carried over between chunks
+            bool stringIsKey;
+            std::string currentString;
+            std::string currentNumber;
+            size_t numberStart;
+            uint32_t codePoint;
+            int hexDigits;
+
+            // Offset of the digits of the current \u escape
+            size_t digitsStart;
+
+            // Lead surrogate of a \u escape waiting for its trail
+            // surrogate, 0 if none, and the offset of its digits
+            uint32_t leadSurrogate;
+            size_t leadStart;
+            const char * literal;
+            size_t literalSize;
+            size_t literalMatched;
+    };
+
+    void StreamParser::reset() {
+        if (target) {
+            // Drop the containers of a failed parse
+            builder.reset(*target);
+        }
+
+        state = EXPECT_VALUE;
+        started = false;
+        chunk = 0;
+        consumed = 0;
+        lines = 0;
+        lineStart = 0;
+        containers.clear();
+        currentString.clear();
+        currentNumber.clear();
+        leadSurrogate = 0;
+    }
+
+    /**
+     * Entry points
+     */
+    void StreamParser::feed(const char *data, size_t length) {
+        if (length == 0) {
+            return;
+        }
+
+        if (!started) {
+            started = true;
+            if (target) {
+                *target = null;
+            }
+        }
+
+        const char* p = data;
+        const char* end = data + length;
+        chunk = data;
+        while (p < end) {
+            switch (state) {
+            case IN_STRING:
+                p = readString(p, end);
+                break;
+            case IN_ESCAPE:
+            case IN_UNICODE:
+                p = readEscape(p, end);
+                break;
+            case IN_LITERAL:
+                p = readLiteral(p, end);
+                break;
+            case IN_NUMBER:
+                p = readNumber(p, end);
+                break;
+            default:
+                p = simd::skipWhitespace(p, end);
+                if (p < end) {
+                    p = readToken(p, end);
+                }
+                break;
+            }
+        }
+
+        size_t newlines = simd::countNewlines(data, end);
+        if (newlines > 0) {
+            lines += newlines;
+            const char* last = end - 1;
+            while (*last != '\n') {
+                last--;
+            }
+            lineStart = consumed + (last + 1 - data);
+        }
+        consumed += length;
+        chunk = 0;
+    }
+
+    ParseError StreamParser::locate(ParseErrorCode code,
+        const char* p) const {
+        return locate(code, consumed + (p - chunk));
+    }
+
+    ParseError StreamParser::locate(ParseErrorCode code,
+        size_t offset) const {
+        ParseError error;
+        error.code = code;
+        error.offset = offset;
+        error.line = lines + 1;
+        size_t start = lineStart;
+
+        // Newlines within the current chunk
+        if (chunk && offset > consumed) {
+            const char* p = chunk + (offset - consumed);
+            size_t newlines = simd::countNewlines(chunk, p);
+            if (newlines > 0) {
+                error.line += newlines;
+                while (p[-1] != '\n') {
+                    p--;
+                }
+                start = consumed + (p - chunk);
+            }
+        }
+        error.column = offset - start + 1;
+        return error;
+    }
+
+    void StreamParser::feed(const std::string& data) {
+        feed(data.data(), data.length());
+    }
+
+    void StreamParser::finish() {
+        if (!started) {
+            return;
+        }
+
+        if (state == IN_NUMBER) {
+            // Numbers have no terminator of their own
+            emitNumber(currentNumber.data(),
+                currentNumber.data() + currentNumber.length());
+        }
+
+        if (state != DONE) {
+            invalidLead();
+            ELSON_THROW(UnexpectedEndOfInputException(
+                locate(PARSE_UNEXPECTED_END, consumed)));
+        }
+        reset();
+    }
+
+    /**
+     * The first character of a token between values
+     */
+    const char* StreamParser::readToken(const char* p, const char* end) {
+        char code = *p;
+        switch (state) {
+        case EXPECT_FIRST_VALUE:
+            if (code == ']') {
+                containers.pop_back();
+                handler->endArray();
+                valueDone();
+                return p + 1;
+            }
+            return startValue(p, end);
+
+        case EXPECT_VALUE:
+            return startValue(p, end);
+
+        case EXPECT_FIRST_KEY:
+            if (code == '}') {
+                containers.pop_back();
+                handler->endObject();
+                valueDone();
+                return p + 1;
+            }
+            // Fall through
+        case EXPECT_KEY:
+            if (code != ESC_QUOTATION_MARK) {
+                ELSON_THROW(ParseException(locate(PARSE_SYNTAX_ERROR, p)));
+            }
+            stringIsKey = true;
+            currentString.clear();
+            leadSurrogate = 0;
+            state = IN_STRING;
+            return p + 1;
+
+        case EXPECT_COLON:
+            if (code != ':') {
+                ELSON_THROW(ParseException(locate(PARSE_SYNTAX_ERROR, p)));
+            }
+            state = EXPECT_VALUE;
+            return p + 1;
+
+        case EXPECT_NEXT: {
+            bool inArray = containers.back() == '[';
+            if (code == ',') {
+                state = inArray ? EXPECT_VALUE : EXPECT_KEY;
+            } else if (code == ']' && inArray) {
+                containers.pop_back();
+                handler->endArray();
+                valueDone();
+            } else if (code == '}' && !inArray) {
+                containers.pop_back();
+                handler->endObject();
+                valueDone();
+            } else {
+                ELSON_THROW(ParseException(locate(PARSE_SYNTAX_ERROR, p)));
+            }
+            return p + 1;
+        }
+
+        default:
+            // Only whitespace may follow the root value
+            ELSON_THROW(UnexpectedCharactersException(
+                locate(PARSE_UNEXPECTED_CHARACTERS, p)));
+        }
+    }
+
+    /**
+     * { | [ | " | literals | numbers
+     */
+    const char* StreamParser::startValue(const char* p, const char* end) {
+        switch (*p) {
+        case '{':
+            checkDepth(p);
+            handler->startObject();
+            containers.push_back('{');
+            state = EXPECT_FIRST_KEY;
+            return p + 1;
+        case '[':
+            checkDepth(p);
+            handler->startArray();
+            containers.push_back('[');
+            state = EXPECT_FIRST_VALUE;
+            return p + 1;
+        case '"':
+            stringIsKey = false;
+            currentString.clear();
+            leadSurrogate = 0;
+            state = IN_STRING;
+            return p + 1;
+        case 't':
+            literal = "true";
+            literalSize = 4;
+            break;
+        case 'f':
+            literal = "false";
+            literalSize = 5;
+            break;
+        case 'n':
+            literal = "null";
+            literalSize = 4;
+            break;
+        default:
+            if ((*p >= '0' && *p <= '9') || *p == '-') {
+                currentNumber.clear();
+                numberStart = consumed + (p - chunk);
+                state = IN_NUMBER;
+                return readNumber(p, end);
+            }
+            ELSON_THROW(ParseException(locate(PARSE_SYNTAX_ERROR, p)));
+        }
+
+        literalMatched = 0;
+        state = IN_LITERAL;
+        return readLiteral(p, end);
+    }
+
+    /**
+     * "..."
+     * Appends whole spans up to the next quote, backslash or control
+     * character.
+     */
+    const char* StreamParser::readString(const char* p, const char* end) {
+        if (p != end && *p != ESC_REVERSE_SOLIUDS) {
+            invalidLead();
+        }
+
+        const char* special = simd::findStringSpecial(p, end);
+        currentString.append(p, special);
+        p = special;
+
+        if (p == end) {
+            return p;
+        } else if (*p == ESC_REVERSE_SOLIUDS) {
+            state = IN_ESCAPE;
+        } else if (*p == ESC_QUOTATION_MARK) {
+            if (stringIsKey) {
+                handler->key(currentString);
+                state = EXPECT_COLON;
+            } else {
+                handler->string(currentString);
+                valueDone();
+            }
+        } else {
+            // Raw control characters are not allowed
+            ELSON_THROW(ParseException(locate(PARSE_SYNTAX_ERROR, p)));
+        }
+        return p + 1;
+    }
+
+    /**
+     * The characters after a backslash
+     */
+    const char* StreamParser::readEscape(const char* p, const char* end) {
+        if (state == IN_ESCAPE) {
+            if (*p != ESC_UNICODE) {
+                invalidLead();
+            }
+            if (*p == ESC_UNICODE) {
+                codePoint = 0;
+                hexDigits = 0;
+                digitsStart = consumed + (p + 1 - chunk);
+                state = IN_UNICODE;
+                return p + 1;
+            }
+
+            char escaped = strings::escapedCharacter(*p);
+            if (!escaped) {
+                ELSON_THROW(ParseException(locate(PARSE_SYNTAX_ERROR, p)));
+            }
+            currentString.push_back(escaped);
+            state = IN_STRING;
+            return p + 1;
+        }
+
+        // \uXXXX, the digits may be split across chunks
+        for (; p < end && hexDigits < 4; p++, hexDigits++) {
+            if (!strings::validHexDigit(*p)) {
+                invalidLead();
+                ELSON_THROW(ParseException(locate(PARSE_SYNTAX_ERROR, p)));
+            }
+            codePoint = (codePoint << 4) | strings::hexDigitValue(*p);
+        }
+
+        if (hexDigits == 4) {
+            if (leadSurrogate) {
+                // Only a trail surrogate may follow
+                if (codePoint < 0xDC00 || codePoint > 0xDFFF) {
+                    invalidLead();
+                }
+                codePoint = 0x10000
+                    + ((leadSurrogate - 0xD800) << 10) + (codePoint - 0xDC00);
+                leadSurrogate = 0;
+            } else if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                leadSurrogate = codePoint;
+                leadStart = digitsStart;
+                state = IN_STRING;
+                return p;
+            } else if (!utf8::is_code_point_valid(codePoint)) {
+                // A lone trail surrogate
+                ELSON_THROW(InvalidCodePointException(codePoint,
+                    locate(PARSE_INVALID_CODE_POINT, digitsStart)));
+            }
+            utf8::append(codePoint, std::back_inserter(currentString));
+            state = IN_STRING;
+        }
+        return p;
+    }
+
+    /**
+     * null | true | false
+     */
+    const char* StreamParser::readLiteral(const char* p, const char* end) {
+        size_t size = (size_t) (end - p);
+        if (size > literalSize - literalMatched) {
+            size = literalSize - literalMatched;
+        }
+        if (memcmp(p, literal + literalMatched, size) != 0) {
+            // Report the first byte that differs
+            while (*p == literal[literalMatched]) {
+                p++;
+                literalMatched++;
+            }
+            ELSON_THROW(ParseException(locate(PARSE_SYNTAX_ERROR, p)));
+        }
+
+        literalMatched += size;
+        if (literalMatched == literalSize) {
+            if (*literal == 'n') {
+                handler->null();
+            } else {
+                handler->boolean(*literal == 't');
+            }
+            valueDone();
+        }
+        return p + size;
+    }
+
+    /**
+     * numbers
+     * Numbers that end within the chunk are scanned in place, only
+     * those cut off by the end of a chunk are collected first.
+     */
+    const char* StreamParser::readNumber(const char* p, const char* end) {
+        const char* begin = p;
+        while (p < end && isNumberCharacter(*p)) {
+            p++;
+        }
+
+        if (p == end) {
+            currentNumber.append(begin, p);
+        } else if (currentNumber.empty()) {
+            emitNumber(begin, p);
+        } else {
+            currentNumber.append(begin, p);
+            emitNumber(currentNumber.data(),
+                currentNumber.data() + currentNumber.length());
+        }
+        return p;
+    }
+
+    void StreamParser::emitNumber(const char* begin, const char* end) {
+        number::Number result;
+        const char* last = number::scan(begin, end, result);
+        if (!last) {
+            ELSON_THROW(ParseException(
+                locate(PARSE_SYNTAX_ERROR, numberStart)));
+        }
+
+        switch (result.type) {
+        case NUMBER_INTEGER:
+            handler->integer(result.integer);
+            break;
+        case NUMBER_UNSIGNED:
+            handler->unsignedInteger(result.uinteger);
+            break;
+        default:
+            handler->number(result.floating);
+            break;
+        }
+        valueDone();
+
+        if (last != end) {
+            // Leftovers such as the "1" of "01"
+            size_t offset = numberStart + (last - begin);
+            if (state == DONE) {
+                ELSON_THROW(UnexpectedCharactersException(
+                    locate(PARSE_UNEXPECTED_CHARACTERS, offset)));
+            }
+            ELSON_THROW(ParseException(
+                locate(PARSE_SYNTAX_ERROR, offset)));
+        }
+    }
+}
+
+#endif // STREAMPARSER_H
@@ -0,0 +1,304 @@
+#ifndef STRINGS_HPP
+#define STRINGS_HPP
+
+#include <string>
+#include <iterator>
+#include <stdint.h>
+
+#include "Simd.hpp"
+#include "Sink.hpp"
+#include "Utf8.hpp"
+
+namespace JSON {
+    // JSON escape characters that may appear
+    // after a reverse solidus
+    const char ESC_REVERSE_SOLIUDS  = 92;
+    const char ESC_QUOTATION_MARK   = 34;
+    const char ESC_SOLIDUS          = 47;
+    const char ESC_BACKSPACE        = 98;
+    const char ESC_FORMFEED         = 102;
+    const char ESC_NEWLINE          = 110;
+    const char ESC_CARRET           = 114;
+    const char ESC_HORIZONTAL_TAB   = 116;
+    const char ESC_UNICODE          = 117;
+
+    // How printed strings are escaped
+    enum Escaping {
+        // Only what JSON requires, UTF-8 is written as it is
+        ESCAPE_MINIMAL,
+        // Also everything beyond ASCII as \uXXXX (or surrogate pairs)
+        ESCAPE_ASCII
+    };
+
+namespace strings {
+/**
+ * String decoding shared by the parsers and encoding shared by the
+ * printers. Decoding works on the input buffer and reports errors by
+ * position so that each parser can raise them in its own way.
+ */
+
+    // Valid digit within an \u2360 unicode escape?
+    inline bool validHexDigit(char code) {
+        return (code >= 48 && code <= 57)
+            || (code >= 65 && code <= 70)
+            || (code >= 97 && code <= 102);
+    }
+
+    // Value of a hex digit that passed validHexDigit
+    inline uint32_t hexDigitValue(char code) {
+        return code <= '9' ? code - '0' : (code | 0x20) - 'a' + 10;
+    }
+
+    // The character a single character escape (\n, \" ...) stands
+    // for or 0 if code does not introduce one.
+    inline char escapedCharacter(char code) {
+        switch (code) {
+            case ESC_BACKSPACE:         return (char) 8;
+            case ESC_HORIZONTAL_TAB:    return (char) 9;
+            case ESC_NEWLINE:           return (char) 10;
+            case ESC_FORMFEED:          return (char) 12;
+            case ESC_CARRET:            return (char) 13;
+            case ESC_QUOTATION_MARK:
+            case ESC_REVERSE_SOLIUDS:
+            case ESC_SOLIDUS:           return code;
+            default:                    return 0;
+        }
+    }
+
+    // Read four hex digits at p. Returns the position after them
+    // or 0.
+    inline const char* readHex4(
+        const char* p, const char* end, uint32_t& value) {
+        if (end - p < 4) {
+            return 0;
+        }
+
+        value = 0;
+        for (int index = 0; index < 4; index++, p++) {
+            if (!validHexDigit(*p)) {
+                return 0;
+            }
+            value = (value << 4) | hexDigitValue(*p);
+        }
+        return p;
+    }
+
+    // Read the four hex digits of a \u escape at p and append the
+    // code point. A lead surrogate followed by an escaped trail
+    // surrogate is combined into one code point. Returns the position
+    // after the digits or 0 (also for a lone surrogate).
+    inline const char* readUTF8Escape(
+        const char* p, const char* end, std::string& buffer) {
+        uint32_t codePoint;
+        p = readHex4(p, end, codePoint);
+        if (!p) {
+            return 0;
+        }
+
+        uint32_t trail;
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF && end - p >= 6
+            && p[0] == ESC_REVERSE_SOLIUDS && p[1] == ESC_UNICODE
+            && readHex4(p + 2, end, trail)
+            && trail >= 0xDC00 && trail <= 0xDFFF) {
+            codePoint = 0x10000
+                + ((codePoint - 0xD800) << 10) + (trail - 0xDC00);
+            p += 6;
+        }
+
+        if (!utf8::is_code_point_valid(codePoint)) {
+            return 0;
+        }
+        utf8::append(codePoint, std::back_inserter(buffer));
+        return p;
+    }
+
+    /**
+     * Decode the string content starting after the opening quote
+     * at p into buffer. Characters between escapes are copied as
+     * whole spans. Returns the position after the closing quote.
+     *
+     * On error 0 is returned and error points to the offending
+     * character (or end if the input ended within the string).
+     * Nothing is thrown.
+     */
+    inline const char* unescape(const char* p, const char* end,
+        std::string& buffer, const char*& error) {
+        buffer.clear();
+        for (;;) {
+            const char* special = simd::findStringSpecial(p, end);
+            buffer.append(p, special);
+            p = special;
+
+            if (p == end) {
+                error = end;
+                return 0;
+            } else if (*p == ESC_QUOTATION_MARK) {
+                return p + 1;
+            } else if (*p != ESC_REVERSE_SOLIUDS) {
+                // Raw control characters are not allowed
+                error = p;
+                return 0;
+            }
+
+            // String contains an escaped character
+            if (++p == end) {
+                error = end;
+                return 0;
+            }
+            if (*p == ESC_UNICODE) {
+                // a \u occured
+                // read the following sequence and insert it's
+                // unicode representation into the string.
+                const char* digits = p + 1;
+                p = readUTF8Escape(digits, end, buffer);
+                if (!p) {
+                    // Point to the first bad digit, or to the digits
+                    // if they are not a code point by themselves
+                    error = digits;
+                    while (error != end && validHexDigit(*error)) {
+                        error++;
+                    }
+                    if (error - digits >= 4) {
+                        error = digits;
+                    }
+                    return 0;
+                }
+                continue;
+            }
+
+            char escaped = escapedCharacter(*p);
+            if (!escaped) {
+                error = p;
+                return 0;
+            }
+            buffer.push_back(escaped);
+            p++;
+        }
+    }
+
+    // Tells if an error reported by unescape is a \u escape with
+    // valid digits that is not a code point by itself (a lone
+    // surrogate) and returns its value.
+    inline bool invalidCodePoint(const char* error, const char* end,
+        uint32_t& codePoint) {
+        return error != end && error[-1] == ESC_UNICODE
+            && readHex4(error, end, codePoint);
+    }
+
+    // The letter of the short escape for code (\n, \" ...) or 0
+    inline char shortEscape(char code) {
+        switch (code) {
+            case 8:                     return ESC_BACKSPACE;
+            case 9:                     return ESC_HORIZONTAL_TAB;
+            case 10:                    return ESC_NEWLINE;
+            case 12:                    return ESC_FORMFEED;
+            case 13:                    return ESC_CARRET;
+            case ESC_QUOTATION_MARK:
+            case ESC_REVERSE_SOLIUDS:   return code;
+            default:                    return 0;
+        }
+    }
+
+    // Write \uXXXX for a code point of the basic multilingual plane
+    inline void writeUnicodeEscape(uint32_t codePoint, Sink& out) {
+        static const char digits[] = "0123456789abcdef";
+        char escape[6] = { ESC_REVERSE_SOLIUDS, ESC_UNICODE,
+            digits[(codePoint >> 12) & 0xF], digits[(codePoint >> 8) & 0xF],
+            digits[(codePoint >> 4) & 0xF], digits[codePoint & 0xF] };
+        out.write(escape, sizeof(escape));
+    }
+
+    // Decode the UTF-8 sequence at p. Returns its length or 0 if it
+    // is invalid (overlong, truncated, a surrogate or beyond the
+    // last code point).
+    inline size_t decodeUTF8(
+        const char* p, const char* end, uint32_t& codePoint) {
+        unsigned char lead = (unsigned char) *p;
+        size_t length;
+        uint32_t minimum;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+            minimum = 0x80;
+            codePoint = lead & 0x1F;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            minimum = 0x800;
+            codePoint = lead & 0x0F;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            minimum = 0x10000;
+            codePoint = lead & 0x07;
+        } else {
+            return 0;
+        }
+
+        if ((size_t) (end - p) < length) {
+            return 0;
+        }
+        for (size_t index = 1; index < length; index++) {
+            unsigned char next = (unsigned char) p[index];
+            if ((next & 0xC0) != 0x80) {
+                return 0;
+            }
+            codePoint = (codePoint << 6) | (next & 0x3F);
+        }
+
+        if (codePoint < minimum || !utf8::is_code_point_valid(codePoint)) {
+            return 0;
+        }
+        return length;
+    }
+
+    /**
+     * Write the string content [p, end) escaped as RFC 8259 requires:
+     * quotes, backslashes and control characters. Runs of characters
+     * that need no escaping are found with SIMD and copied as a whole.
+     *
+     * With ESCAPE_ASCII everything beyond ASCII is escaped as well.
+     * Invalid UTF-8 then becomes U+FFFD.
+     */
+    inline void escape(const char* p, const char* end, Sink& out,
+        Escaping escaping = ESCAPE_MINIMAL) {
+        for (;;) {
+            const char* special = escaping == ESCAPE_ASCII
+                ? simd::findStringSpecialOrNonAscii(p, end)
+                : simd::findStringSpecial(p, end);
+            if (special != p) {
+                out.write(p, special - p);
+                p = special;
+            }
+            if (p == end) {
+                return;
+            }
+
+            if ((unsigned char) *p >= 0x80) {
+                uint32_t codePoint;
+                size_t length = decodeUTF8(p, end, codePoint);
+                if (!length) {
+                    codePoint = 0xFFFD;
+                    length = 1;
+                }
+                if (codePoint >= 0x10000) {
+                    codePoint -= 0x10000;
+                    writeUnicodeEscape(0xD800 + (codePoint >> 10), out);
+                    writeUnicodeEscape(0xDC00 + (codePoint & 0x3FF), out);
+                } else {
+                    writeUnicodeEscape(codePoint, out);
+                }
+                p += length;
+                continue;
+            }
+
+            char letter = shortEscape(*p);
+            if (letter) {
+                char escape[2] = { ESC_REVERSE_SOLIUDS, letter };
+                out.write(escape, 2);
+            } else {
+                writeUnicodeEscape((unsigned char) *p, out);
+            }
+            p++;
+        }
+    }
+}   }
+
+#endif // STRINGS_HPP
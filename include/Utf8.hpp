@@ -55,7 +55,7 @@ namespace JSON { namespace utf8 {
     template <typename octet_iterator>
     octet_iterator append(uint32_t cp, octet_iterator result) {
         if (!is_code_point_valid(cp))
-            throw InvalidCodePointException(cp);
+            ELSON_THROW(InvalidCodePointException(cp));
 
         if (cp < 0x80)                        // one octet
             *(result++) = static_cast<uint8_t>(cp);
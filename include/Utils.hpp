@@ -16,8 +16,9 @@ namespace JSON {
             return properties;
         }
         
-        for (auto p: object.asMutable<Object>()) {
-            properties.push_back(Property {p.first, &p.second});
+        for (auto& p: object.asMutable<Object>()) {
+            properties.push_back(Property {
+                std::string(p.first.data(), p.first.length()), &p.second});
         }
         
         return properties;
@@ -30,11 +31,12 @@ namespace JSON {
 		    return properties;
         }
 
-        for (auto p: object.asMutable<Object>()) {
+        for (auto& p: object.asMutable<Object>()) {
             if (p.second.is(JSON_OBJECT)) {
                 traverse(properties, p.second);
             } else {
-                properties.push_back(Property {p.first, &p.second});
+                properties.push_back(Property {
+                std::string(p.first.data(), p.first.length()), &p.second});
             }
         }
 
@@ -46,7 +48,7 @@ namespace JSON {
         std::function<bool(std::string, Value&)> filterFunction) {
         
         PropertyList list;
-        for (auto p: properties) {
+        for (const auto& p: properties) {
             Value& candidate = *p.second;
             if (filterFunction(p.first, candidate)) {
                 list.push_back(p);
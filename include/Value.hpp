@@ -1,19 +1,41 @@
 #ifndef VALUE_H
 #define VALUE_H
 
+#include <algorithm>
 #include <sstream>
 #include <vector>
-#include <tuple>
+#include <stdexcept>
+#include <string>
 #include <cmath>
+#include <stdint.h>
+#include <string.h>
+#include <tuple>
+#include <utility>
+
+#if __cplusplus >= 201703L
+#   include <string_view>
+#   define ELSON_HAS_STRING_VIEW
+#endif
+
+#include "Exceptions.hpp"
+#include "MemoryResource.hpp"
+#include "Number.hpp"
 
 namespace JSON {
     // Forward declaration needed for typedefs.
     struct Value;
-    
-    // JSON Objects and Arrays are actually only typedef'd
-    // std maps and vectors.
-    typedef std::vector<Value>            Array;
-    typedef std::map<std::string, Value>  Object;
+    class Key;
+    class Object;
+    template <typename T> class Allocator;
+
+    // JSON Arrays are actually only typedef'd std vectors, Objects
+    // are flat vectors of Key/Value pairs (see below). They, their
+    // keys and the strings allocate through a JSON::Allocator which
+    // uses the heap unless the value was given a MemoryResource (e.g.
+    // the arena of a Document).
+    typedef std::basic_string<char, std::char_traits<char>,
+                              Allocator<char> >             String;
+    typedef std::vector<Value, Allocator<Value> >           Array;
     
     // Convert x to String
     template<typename T> std::string toString(const T& t) {
@@ -35,79 +57,149 @@ namespace JSON {
         // Construction with no argument is interpreted as
         // JSON null.
         Value() 
-        : type(JSON_NULL) { 
+        : type(JSON_NULL), resource(0) { 
+            // Moves copy the payload whatever the type
+            value.integer = 0;
+        }
+
+        // Null value that allocates its payloads from resource
+        explicit Value(MemoryResource * resource)
+        : type(JSON_NULL), resource(resource) {
+            value.integer = 0;
         }
         
         // JSON_NUMBER
         Value(int val) 
-        : type(JSON_NUMBER) {
-            std::get<JSON_NUMBER>(value) = val;
+        : type(JSON_NUMBER), numberType(NUMBER_INTEGER), resource(0) {
+            value.integer = val;
         }
     
         Value(long int val) 
-        : type(JSON_NUMBER) {
-            std::get<JSON_NUMBER>(value) = (int) val;
+        : type(JSON_NUMBER), numberType(NUMBER_INTEGER), resource(0) {
+            value.integer = val;
+        }
+
+        Value(long long int val) 
+        : type(JSON_NUMBER), numberType(NUMBER_INTEGER), resource(0) {
+            value.integer = val;
         }
     
         Value(unsigned int val) 
-        : type(JSON_NUMBER) {
-            std::get<JSON_NUMBER>(value) = (int) val;
+        : type(JSON_NUMBER), numberType(NUMBER_INTEGER), resource(0) {
+            value.integer = val;
         }
-    
-        Value(double val) 
-        : type(JSON_NUMBER) {
-            std::get<JSON_NUMBER>(value) = val;
+
+        Value(unsigned long int val) 
+        : type(JSON_NUMBER), resource(0) {
+            setUnsigned(val);
         }
 
-        // JSON_STRING
-        Value(const char * val)
-        : type(JSON_STRING) {
-            std::get<JSON_STRING>(value) = std::string(val);
+        Value(unsigned long long int val) 
+        : type(JSON_NUMBER), resource(0) {
+            setUnsigned(val);
         }
     
-        Value(const std::string& val)
-        : type(JSON_STRING) {
-            std::get<JSON_STRING>(value) = val;
+        Value(double val) 
+        : type(JSON_NUMBER), numberType(NUMBER_FLOAT), resource(0) {
+            value.number = val;
         }
 
+        // JSON_STRING
+        Value(const char * val);
+        Value(const std::string& val);
+
         // JSON_BOOL
         Value(bool val)
-        : type(JSON_BOOL) {
-            std::get<JSON_BOOL>(value) = val;
+        : type(JSON_BOOL), resource(0) {
+            value.boolean = val;
         }
 
         // JSON_ARRAY
-        Value(const Array& val) 
-        : type(JSON_ARRAY) {
-            std::get<JSON_ARRAY>(value) = val;
-        }
+        Value(const Array& val);
+        Value(Array&& val);
 
         // Array construction from initializer list
         // Value a {1, 2, 3};
-        Value(std::initializer_list<Value> val) 
-        : type(JSON_ARRAY) {
-            std::get<JSON_ARRAY>(value) = Array(val);
-        }
+        Value(std::initializer_list<Value> val);
 
         // JSON_OBJECT
-        Value(const Object& val) 
-        : type(JSON_OBJECT) {
-            std::get<JSON_OBJECT>(value) = val;
+        Value(const Object& val);
+        Value(Object&& val);
+
+        // Copies are deep and go to the heap (or to the given
+        // resource). Moves steal the payload and leave null behind,
+        // the new value keeps using the resource of other. A value
+        // move constructed out of a Document still lives in its
+        // arena, copy it (or move assign it to a heap value) to
+        // keep it beyond the document's tree.
+        Value(const Value& other);
+        Value(const Value& other, MemoryResource * resource);
+        Value(Value&& other) noexcept;
+
+        ~Value() {
+            release();
         }
+
+        // Assignment keeps the resource of this value, payloads from
+        // elsewhere are copied into it.
+        Value& operator=(const Value& other);
+        Value& operator=(Value&& other);
         
         // Access and construction by [] operator
-        Value& operator[](const std::string& key) {
-            // This may also be used for construction so
-            // ensure that the value is object type.
-            type = JSON_OBJECT;
-            return std::get<JSON_OBJECT>(value)[key];
+        Value& operator[](const std::string& key);
+
+        // Object lookup without modification. find returns 0 (and
+        // at throws std::out_of_range) if this is not an object or
+        // the key is missing. Keys are compared in place, no
+        // strings are built.
+        const Value* find(const char * key, size_t length) const;
+        const Value& at(const char * key, size_t length) const;
+
+        const Value* find(const char * key) const {
+            return find(key, strlen(key));
         }
 
-        // Array access and manipulation
-        Value& operator[](int index) {
-            return std::get<JSON_ARRAY>(value)[index];
+        const Value* find(const std::string& key) const {
+            return find(key.data(), key.length());
+        }
+
+        const Value& at(const char * key) const {
+            return at(key, strlen(key));
         }
 
+        const Value& at(const std::string& key) const {
+            return at(key.data(), key.length());
+        }
+
+        bool contains(const char * key, size_t length) const {
+            return find(key, length) != 0;
+        }
+
+        bool contains(const char * key) const {
+            return find(key) != 0;
+        }
+
+        bool contains(const std::string& key) const {
+            return find(key) != 0;
+        }
+
+#if defined(ELSON_HAS_STRING_VIEW)
+        const Value* find(std::string_view key) const {
+            return find(key.data(), key.length());
+        }
+
+        const Value& at(std::string_view key) const {
+            return at(key.data(), key.length());
+        }
+
+        bool contains(std::string_view key) const {
+            return find(key) != 0;
+        }
+#endif
+
+        // Array access and manipulation
+        Value& operator[](int index);
+
         bool is(JsonType type) const {
             return this->type == type;
         }
@@ -116,125 +208,1665 @@ namespace JSON {
             return type;
         }
 
-        void push_back(const Value& val) {
-            std::get<JSON_ARRAY>(value).push_back(val);
+        // Representation of a JSON_NUMBER. Meaningless for
+        // other types.
+        NumberType getNumberType() const {
+            return numberType;
+        }
+
+        // True for numbers stored as exact integers
+        bool isInteger() const {
+            return type == JSON_NUMBER && numberType != NUMBER_FLOAT;
         }
 
+        // Where strings and containers are allocated, 0 for the heap
+        MemoryResource * getResource() const {
+            return resource;
+        }
+
+        void push_back(const Value& val);
+
         // Value access (and conversion)
-        template <typename T> T as() const throw(ConversionException);
-        template <typename T> T& asMutable();                
+        template <typename T> T as() const;
+        template <typename T> T& asMutable();
+
+        // Read only access to strings and containers without
+        // copying them. Other types throw a ConversionException.
+        const String& asString() const;
+        const Array& asArray() const;
+        const Object& asObject() const;                
     private:
+        template <typename T> friend class Allocator;
+
+        // Unsigned values that fit are stored as signed integers
+        // so that there is only one representation for them.
+        void setUnsigned(uint64_t val) {
+            if (val > (uint64_t) INT64_MAX) {
+                numberType = NUMBER_UNSIGNED;
+                value.uinteger = val;
+            } else {
+                numberType = NUMBER_INTEGER;
+                value.integer = (int64_t) val;
+            }
+        }
+
+        // Round trip representation of a number
+        std::string numberToString() const {
+            char buffer[number::FORMAT_BUFFER_SIZE];
+            char* end;
+            switch (numberType) {
+            case NUMBER_INTEGER:
+                end = number::format(value.integer, buffer);
+                break;
+            case NUMBER_UNSIGNED:
+                end = number::format(value.uinteger, buffer);
+                break;
+            default:
+                end = number::format(value.number, buffer);
+                break;
+            }
+            return std::string(buffer, end);
+        }
+
+        // Strings and containers are not stored inline
+        bool hasPayload() const {
+            return type == JSON_STRING || type == JSON_ARRAY
+                || type == JSON_OBJECT;
+        }
+
+        // Numeric conversion that reads integers directly
+        template <typename T> T asNumeric() const;
+
+        // Allocate and destroy payloads with the allocator of
+        // this value
+        template <typename T, typename... Args> T* create(Args&&... args);
+        template <typename T> void destroy(T* payload);
+
+        // Free the payload (if any) and turn this value into null.
+        // Payloads of monotonic resources are left to the resource.
+        void release();
+
+        // Deep copy the payload of other. The type must
+        // already be set.
+        void copyPayload(const Value& other);
+
+        // Move the payload into another resource (copying it)
+        void adopt(MemoryResource * target);
+
         // The actual type of the value.
         JsonType type;
+
+        // The representation of a number.
+        NumberType numberType = NUMBER_FLOAT;
+
+        // Where strings and containers are allocated
+        MemoryResource * resource;
         
-        // The actual value is stored in the appropriate slot
-        // of the tuple.
-        std::tuple<
-            std::string,
-            double,
-            bool,
-            Array,
-            Object
-        > value;
+        // Only the member selected by type is active. Strings and
+        // containers live on the heap to keep scalars small.
+        union Payload {
+            double          number;
+            int64_t         integer;
+            uint64_t        uinteger;
+            bool            boolean;
+            String *        string;
+            Array *         array;
+            Object *        object;
+        } value;
+    };
+
+    /**
+     * Key of an object entry. Short keys are stored inline, longer
+     * ones are allocated like the object they belong to. Keys handed
+     * out by a KeyTable refer to the characters of the table instead,
+     * must not outlive it and compare by pointer. Copies always own
+     * their characters.
+     */
+    class Key {
+        public:
+            typedef Allocator<char> allocator_type;
+
+            Key(const char * key = "")
+            : resource(0) {
+                assign(key, strlen(key));
+            }
+
+            Key(const char * key, size_t length)
+            : resource(0) {
+                assign(key, length);
+            }
+
+            Key(const std::string& key)
+            : resource(0) {
+                assign(key.data(), key.length());
+            }
+
+            Key(const Key& other)
+            : resource(0) {
+                assign(other.data(), other.length());
+            }
+
+            Key(const String& key);
+
+            // Allocating like allocator
+            Key(const char * key, size_t length,
+                const allocator_type& allocator);
+            Key(const std::string& key, const allocator_type& allocator);
+            Key(const String& key, const allocator_type& allocator);
+            Key(const Key& other, const allocator_type& allocator);
+
+            Key(Key&& other) noexcept
+            : resource(other.resource) {
+                steal(other);
+            }
+
+            Key(Key&& other, const allocator_type& allocator);
+
+            ~Key() {
+                release();
+            }
+
+            Key& operator=(const Key& other);
+            Key& operator=(Key&& other);
+
+            const char * data() const {
+                return isLocal() ? storage : remote();
+            }
+
+            const char * c_str() const {
+                return data();
+            }
+
+            size_t length() const {
+                return isLocal() ? tag() : remoteLength();
+            }
+
+            size_t size() const {
+                return length();
+            }
+
+            bool empty() const {
+                return length() == 0;
+            }
+
+            // Shared with all keys of the same KeyTable
+            bool isInterned() const {
+                return tag() == INTERNED;
+            }
+
+            allocator_type get_allocator() const;
+
+            // Ordered like std::string: bytewise, then by length
+            int compare(const char * key, size_t length) const;
+            int compare(const Key& other) const;
+
+            bool equals(const char * key, size_t length) const {
+                return this->length() == length
+                    && (data() == key || memcmp(data(), key, length) == 0);
+            }
+
+            static size_t hash(const char * key, size_t length);
+
+        private:
+            friend class KeyTable;
+
+            // Keys up to this length are stored inline
+            static const size_t LOCAL_SIZE = 14;
+
+            // The last byte of the storage holds the length of local
+            // keys or tells where remote characters come from.
+            static const unsigned char OWNED = 0x80;
+            static const unsigned char INTERNED = 0x81;
+
+            unsigned char tag() const {
+                return (unsigned char) storage[sizeof(storage) - 1];
+            }
+
+            bool isLocal() const {
+                return tag() <= LOCAL_SIZE;
+            }
+
+            const char * remote() const {
+                const char * characters;
+                memcpy(&characters, storage, sizeof(characters));
+                return characters;
+            }
+
+            uint32_t remoteLength() const {
+                uint32_t length;
+                memcpy(&length, storage + 8, sizeof(length));
+                return length;
+            }
+
+            void setRemote(const char * characters, size_t length,
+                unsigned char tag) {
+                uint32_t size = (uint32_t) length;
+                memcpy(storage, &characters, sizeof(characters));
+                memcpy(storage + 8, &size, sizeof(size));
+                storage[sizeof(storage) - 1] = (char) tag;
+            }
+
+            // Copy the characters, the resource must be set
+            void assign(const char * key, size_t length);
+
+            // Take the characters of other and leave it empty
+            void steal(Key& other) {
+                memcpy(storage, other.storage, sizeof(storage));
+                other.storage[0] = 0;
+                other.storage[sizeof(other.storage) - 1] = 0;
+            }
+
+            // Free owned characters and become empty
+            void release();
+
+            // Local characters (null terminated) or pointer and length
+            char storage[16];
+            MemoryResource * resource;
+    };
+
+    /**
+     * Allocates from a MemoryResource or (without one) the heap. Like
+     * std::pmr::polymorphic_allocator containers keep the allocator
+     * they were created with and pass it on to the strings and values
+     * constructed inside of them, so all nodes of a tree use the
+     * same resource.
+     */
+    template <typename T> class Allocator {
+        public:
+            typedef T value_type;
+
+            typedef std::false_type propagate_on_container_copy_assignment;
+            typedef std::false_type propagate_on_container_move_assignment;
+            typedef std::false_type propagate_on_container_swap;
+
+            Allocator(MemoryResource * resource = 0) : resource(resource) { }
+
+            template <typename U> Allocator(const Allocator<U>& other)
+            : resource(other.getResource()) { }
+
+            T* allocate(size_t count) {
+                if (resource) {
+                    return (T*) resource->allocate(
+                        count * sizeof(T), alignof(T));
+                }
+                return (T*) ::operator new(count * sizeof(T));
+            }
+
+            void deallocate(T* pointer, size_t count) {
+                if (resource) {
+                    resource->deallocate(
+                        pointer, count * sizeof(T), alignof(T));
+                } else {
+                    ::operator delete(pointer);
+                }
+            }
+
+            // Copies of containers go to the heap
+            Allocator select_on_container_copy_construction() const {
+                return Allocator();
+            }
+
+            template <typename U, typename... Args>
+            void construct(U* pointer, Args&&... args) {
+                ::new((void*) pointer) U(std::forward<Args>(args)...);
+            }
+
+            // Values end up in the resource of their container
+            template <typename... Args>
+            void construct(Value* pointer, Args&&... args) {
+                ::new((void*) pointer) Value(std::forward<Args>(args)...);
+                pointer->adopt(resource);
+            }
+
+            void construct(Value* pointer, const Value& other) {
+                ::new((void*) pointer) Value(other, resource);
+            }
+
+            void construct(Value* pointer, Value& other) {
+                ::new((void*) pointer) Value(other, resource);
+            }
+
+            // Object entries, keys and values both use the resource
+            template <typename... K, typename... V>
+            void construct(std::pair<Key, Value>* pointer,
+                std::piecewise_construct_t, std::tuple<K...> key,
+                std::tuple<V...> value) {
+                ::new((void*) pointer) std::pair<Key, Value>(
+                    std::piecewise_construct,
+                    std::tuple_cat(std::move(key),
+                        std::tuple<Allocator<char> >(
+                            Allocator<char>(resource))),
+                    std::move(value));
+                pointer->second.adopt(resource);
+            }
+
+            template <typename K, typename V>
+            void construct(std::pair<Key, Value>* pointer,
+                K&& key, V&& value) {
+                construct(pointer, std::piecewise_construct,
+                    std::forward_as_tuple(std::forward<K>(key)),
+                    std::forward_as_tuple(std::forward<V>(value)));
+            }
+
+            template <typename K, typename V>
+            void construct(std::pair<Key, Value>* pointer,
+                const std::pair<K, V>& other) {
+                construct(pointer, other.first, other.second);
+            }
+
+            template <typename K, typename V>
+            void construct(std::pair<Key, Value>* pointer,
+                std::pair<K, V>&& other) {
+                construct(pointer, std::forward<K>(other.first),
+                    std::forward<V>(other.second));
+            }
+
+            template <typename U> void destroy(U* pointer) {
+                pointer->~U();
+            }
+
+            MemoryResource * getResource() const {
+                return resource;
+            }
+
+        private:
+            MemoryResource * resource;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const Allocator<T>& a, const Allocator<U>& b) {
+        return a.getResource() == b.getResource();
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const Allocator<T>& a, const Allocator<U>& b) {
+        return a.getResource() != b.getResource();
+    }
+
+    Key::Key(const char* key, size_t length, const allocator_type& allocator)
+    : resource(allocator.getResource()) {
+        assign(key, length);
+    }
+
+    Key::Key(const std::string& key, const allocator_type& allocator)
+    : resource(allocator.getResource()) {
+        assign(key.data(), key.length());
+    }
+
+    Key::Key(const String& key)
+    : resource(0) {
+        assign(key.data(), key.length());
+    }
+
+    Key::Key(const String& key, const allocator_type& allocator)
+    : resource(allocator.getResource()) {
+        assign(key.data(), key.length());
+    }
+
+    Key::Key(const Key& other, const allocator_type& allocator)
+    : resource(allocator.getResource()) {
+        assign(other.data(), other.length());
+    }
+
+    Key::Key(Key&& other, const allocator_type& allocator)
+    : resource(allocator.getResource()) {
+        if (other.tag() == OWNED && other.resource != resource) {
+            assign(other.data(), other.length());
+        } else {
+            steal(other);
+        }
+    }
+
+    Key::allocator_type Key::get_allocator() const {
+        return allocator_type(resource);
+    }
+
+    Key& Key::operator=(const Key& other) {
+        if (this != &other) {
+            release();
+            assign(other.data(), other.length());
+        }
+        return *this;
+    }
+
+    Key& Key::operator=(Key&& other) {
+        if (this != &other) {
+            release();
+            if (other.tag() == OWNED && other.resource != resource) {
+                assign(other.data(), other.length());
+            } else {
+                steal(other);
+            }
+        }
+        return *this;
+    }
+
+    void Key::assign(const char* key, size_t length) {
+        if (length <= LOCAL_SIZE) {
+            memcpy(storage, key, length);
+            storage[length] = 0;
+            storage[sizeof(storage) - 1] = (char) length;
+            return;
+        }
+
+        char* characters = Allocator<char>(resource).allocate(length + 1);
+        memcpy(characters, key, length);
+        characters[length] = 0;
+        setRemote(characters, length, OWNED);
+    }
+
+    void Key::release() {
+        if (tag() == OWNED) {
+            Allocator<char>(resource).deallocate(
+                (char*) remote(), remoteLength() + 1);
+        }
+        storage[0] = 0;
+        storage[sizeof(storage) - 1] = 0;
+    }
+
+    int Key::compare(const char* key, size_t length) const {
+        size_t own = this->length();
+        const char* characters = data();
+        if (characters != key) {
+            int result = memcmp(characters, key,
+                own < length ? own : length);
+            if (result != 0) {
+                return result;
+            }
+        }
+        return own < length ? -1 : (own > length ? 1 : 0);
+    }
+
+    int Key::compare(const Key& other) const {
+        return compare(other.data(), other.length());
+    }
+
+    /**
+     * 64 bit FNV-1a over words followed by the MurmurHash3 finalizer,
+     * which spreads every input bit over the low bits used by hash
+     * tables.
+     */
+    size_t Key::hash(const char* key, size_t length) {
+        uint64_t hash = 0xcbf29ce484222325ULL ^ length;
+        for (; length >= 8; key += 8, length -= 8) {
+            uint64_t word;
+            memcpy(&word, key, 8);
+            hash = (hash ^ word) * 0x100000001b3ULL;
+        }
+        for (; length > 0; key++, length--) {
+            hash = (hash ^ (unsigned char) *key) * 0x100000001b3ULL;
+        }
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return (size_t) hash;
+    }
+
+    inline bool operator==(const Key& a, const Key& b) {
+        return a.equals(b.data(), b.length());
+    }
+
+    inline bool operator!=(const Key& a, const Key& b) {
+        return !(a == b);
+    }
+
+    inline bool operator<(const Key& a, const Key& b) {
+        return a.compare(b) < 0;
+    }
+
+    inline bool operator>(const Key& a, const Key& b) {
+        return b < a;
+    }
+
+    inline std::ostream& operator<<(std::ostream& out, const Key& key) {
+        return out.write(key.data(), key.length());
+    }
+
+    /**
+     * JSON object: key/value pairs in a single vector. Most objects
+     * only have a handful of keys, for these searching contiguous
+     * memory beats a node based map and iteration does not chase
+     * pointers. Offers the part of the std::map interface that is used
+     * with JSON objects. Adding keys invalidates iterators.
+     *
+     * By default entries are kept sorted by key and looked up with a
+     * binary search. Parsers append keys in document order and sort
+     * the object once it is complete. Objects left unsorted by a
+     * failed parse iterate in document order and are sorted by the
+     * first mutable lookup.
+     *
+     * Keys added one by one (operator[], insert) that do not belong
+     * near the end wait in a second sorted run behind the others.
+     * Once that run outgrows twice the square root of the object it
+     * is merged in, so building an object of n keys in random order
+     * moves about n * sqrt(n) entries instead of n * n / 4: 15 ms for
+     * 10,000 keys and 0.36 s for 100,000 (std::map: 5 ms and 0.1 s).
+     * Iterators walk both runs in key order.
+     *
+     * With ELSON_ORDERED_OBJECTS defined entries keep their insertion
+     * order instead, so printed documents mirror the parsed ones.
+     * Small objects are searched linearly, larger ones get a hash
+     * index.
+     */
+    class Object {
+        public:
+            typedef Key                                     key_type;
+            typedef Value                                   mapped_type;
+            typedef std::pair<Key, Value>                   value_type;
+            typedef Allocator<value_type>                   allocator_type;
+            typedef std::vector<value_type, allocator_type> Entries;
+            typedef Entries::size_type                      size_type;
+
+            // Forward iterator over the entries in key order
+            template <typename Entry> class Cursor {
+                public:
+                    typedef std::forward_iterator_tag   iterator_category;
+                    typedef Object::value_type          value_type;
+                    typedef ptrdiff_t                   difference_type;
+                    typedef Entry*                      pointer;
+                    typedef Entry&                      reference;
+
+                    Cursor() : first(0), firstEnd(0), second(0),
+                        secondEnd(0) { }
+
+                    // Entries from first and from second, both sorted
+                    Cursor(Entry* first, Entry* firstEnd, Entry* second,
+                        Entry* secondEnd)
+                    : first(first), firstEnd(firstEnd), second(second),
+                      secondEnd(secondEnd) { }
+
+                    // iterator converts to const_iterator
+                    template <typename Other>
+                    Cursor(const Cursor<Other>& other)
+                    : first(other.first), firstEnd(other.firstEnd),
+                      second(other.second), secondEnd(other.secondEnd) { }
+
+                    reference operator*() const {
+                        return *current();
+                    }
+
+                    pointer operator->() const {
+                        return current();
+                    }
+
+                    Cursor& operator++() {
+                        if (current() == first) {
+                            ++first;
+                        } else {
+                            ++second;
+                        }
+                        return *this;
+                    }
+
+                    Cursor operator++(int) {
+                        Cursor previous = *this;
+                        ++*this;
+                        return previous;
+                    }
+
+                    template <typename Other>
+                    bool operator==(const Cursor<Other>& other) const {
+                        return first == other.first
+                            && second == other.second;
+                    }
+
+                    template <typename Other>
+                    bool operator!=(const Cursor<Other>& other) const {
+                        return !(*this == other);
+                    }
+
+                private:
+                    template <typename Other> friend class Cursor;
+                    friend class Object;
+
+                    // The smaller key of both runs
+                    Entry* current() const {
+                        if (second == secondEnd || (first != firstEnd
+                            && first->first < second->first)) {
+                            return first;
+                        }
+                        return second;
+                    }
+
+                    Entry* first;
+                    Entry* firstEnd;
+                    Entry* second;
+                    Entry* secondEnd;
+            };
+
+            typedef Cursor<value_type>                      iterator;
+            typedef Cursor<const value_type>                const_iterator;
+
+            Object() : sorted(true), merged(0) { }
+
+            explicit Object(const allocator_type& allocator)
+            : entries(allocator), index(allocator), sorted(true),
+              merged(0) { }
+
+            // Of duplicate keys the first one is kept, like std::map
+            Object(std::initializer_list<value_type> init,
+                const allocator_type& allocator = allocator_type());
+
+            Object(const Object& other, const allocator_type& allocator)
+            : entries(other.entries, allocator),
+              index(other.index, allocator), sorted(other.sorted),
+              merged(other.merged) { }
+
+            Object(Object&& other, const allocator_type& allocator)
+            : entries(std::move(other.entries), allocator),
+              index(std::move(other.index), allocator),
+              sorted(other.sorted), merged(other.merged) { }
+
+            iterator begin() { return cursor(0, merged); }
+            iterator end() { return cursor(merged, entries.size()); }
+
+            const_iterator begin() const {
+                return cursor(0, merged);
+            }
+
+            const_iterator end() const {
+                return cursor(merged, entries.size());
+            }
+
+            size_type size() const { return entries.size(); }
+            bool empty() const { return entries.empty(); }
+            void reserve(size_type count) { entries.reserve(count); }
+
+            void clear() {
+                entries.clear();
+                index.clear();
+                sorted = true;
+                merged = 0;
+            }
+
+            allocator_type get_allocator() const {
+                return entries.get_allocator();
+            }
+
+            // Access and construction, new keys map to null
+            Value& operator[](const String& key);
+            Value& operator[](const std::string& key);
+            Value& operator[](const char * key);
+
+            // Throws std::out_of_range for missing keys
+            Value& at(const char * key, size_t length);
+            const Value& at(const char * key, size_t length) const;
+
+            Value& at(const char * key) {
+                return at(key, strlen(key));
+            }
+
+            const Value& at(const char * key) const {
+                return at(key, strlen(key));
+            }
+
+            Value& at(const std::string& key) {
+                return at(key.data(), key.length());
+            }
+
+            const Value& at(const std::string& key) const {
+                return at(key.data(), key.length());
+            }
+
+            iterator find(const char * key, size_t length);
+            const_iterator find(const char * key, size_t length) const;
+
+            iterator find(const char * key) {
+                return find(key, strlen(key));
+            }
+
+            const_iterator find(const char * key) const {
+                return find(key, strlen(key));
+            }
+
+            iterator find(const String& key) {
+                return find(key.data(), key.length());
+            }
+
+            const_iterator find(const String& key) const {
+                return find(key.data(), key.length());
+            }
+
+            // Interned keys match by pointer
+            iterator find(const Key& key) {
+                return find(key.data(), key.length());
+            }
+
+            const_iterator find(const Key& key) const {
+                return find(key.data(), key.length());
+            }
+
+            iterator find(const std::string& key) {
+                return find(key.data(), key.length());
+            }
+
+            const_iterator find(const std::string& key) const {
+                return find(key.data(), key.length());
+            }
+
+#if defined(ELSON_HAS_STRING_VIEW)
+            iterator find(std::string_view key) {
+                return find(key.data(), key.length());
+            }
+
+            const_iterator find(std::string_view key) const {
+                return find(key.data(), key.length());
+            }
+#endif
+
+            size_type count(const char * key) const {
+                return find(key) == end() ? 0 : 1;
+            }
+
+            size_type count(const std::string& key) const {
+                return find(key) == end() ? 0 : 1;
+            }
+
+            // Existing keys keep their value
+            std::pair<iterator, bool> insert(const value_type& entry);
+            std::pair<iterator, bool> insert(value_type&& entry);
+
+            iterator erase(const_iterator position);
+            size_type erase(const std::string& key);
+
+        private:
+            friend class Value;
+            friend class ValueBuilder;
+
+            // Positions of the entries in a hash index, 0 marks free
+            // slots and n the entry at n - 1.
+            typedef std::vector<uint32_t, Allocator<uint32_t> > Index;
+
+            // Sorted objects up to this size are sorted on the stack
+            static const size_t INSERTION_SORT_SIZE = 32;
+
+            // Ordered objects with more entries are indexed
+            static const size_t INDEX_SIZE = 16;
+
+            // Keys added at most this far from the end of a sorted
+            // object are inserted in place, and at least this many
+            // keys wait before they are merged
+            static const size_t MERGE_SIZE = 64;
+
+            // Add an entry while building an object. Sorted objects
+            // do not look for the key until finish() is called.
+            Value& append(const char * key, size_t length);
+            Value& append(Key&& key);
+
+            // Track whether appended keys arrive in order
+            void appending(const char * key, size_t length);
+
+            // Add an entry, the arguments construct its key. Returns
+            // where the entry ends up.
+            template <typename... Args>
+            size_t emplace(size_t position, Args&&... key);
+
+            // Account for an entry added at position, returns where
+            // it ends up
+            size_t placed(size_t position);
+
+            // Merge the waiting entries into the sorted ones
+            void merge();
+
+            // Called once a built object is complete. Sorts appended
+            // entries, of duplicate keys the last one wins. order is
+            // scratch space for large objects.
+            void finish(std::vector<size_t>& order);
+
+            void finish() {
+                std::vector<size_t> order;
+                finish(order);
+            }
+
+            // Position of key or where it is added if missing
+            size_t search(const char * key, size_t length, bool& found);
+
+            // Index of the first key in [first, last) that is not less
+            // than key
+            size_t lowerBound(const char * key, size_t length,
+                size_t first, size_t last) const;
+
+            // Iterator at entry first of the sorted and entry second
+            // of the waiting ones
+            iterator cursor(size_t first, size_t second) {
+                value_type* data = entries.data();
+                return iterator(data + first, data + merged,
+                    data + second, data + entries.size());
+            }
+
+            const_iterator cursor(size_t first, size_t second) const {
+                const value_type* data = entries.data();
+                return const_iterator(data + first, data + merged,
+                    data + second, data + entries.size());
+            }
+
+            // Iterator at the entry in position
+            iterator iteratorAt(size_t position);
+
+            // Value of key or 0, cheaper than find() since no
+            // iterator is built
+            const Value* get(const char * key, size_t length) const;
+
+            // Position of key in an ordered object or size()
+            size_t locate(const char * key, size_t length) const;
+
+            // Update the hash index after adding or removing entries
+            void indexEntry(size_t position);
+            void reindex();
+
+            bool matches(size_t position, const char * key,
+                size_t length) const {
+                return position < entries.size()
+                    && entries[position].first.equals(key, length);
+            }
+
+            // Entry for key, created if missing
+            Value& lookup(const char * key, size_t length);
+            Value& lookup(Key&& key);
+
+            Entries entries;
+
+            // Hash index of large ordered objects
+            Index index;
+
+            // False while appended entries of a sorted object wait
+            // for finish()
+            bool sorted;
+
+            // Entries before are sorted, the ones after are sorted
+            // among themselves and wait for merge()
+            size_t merged;
     };
+
+    Object::Object(std::initializer_list<value_type> init,
+        const allocator_type& allocator)
+    : entries(allocator), index(allocator), sorted(true), merged(0) {
+        entries.reserve(init.size());
+        for (const value_type& entry : init) {
+            insert(entry);
+        }
+    }
+
+    /**
+     * Keys are ordered like std::string orders them: bytewise, then
+     * by length.
+     */
+    size_t Object::lowerBound(const char* key, size_t length,
+        size_t first, size_t last) const {
+        size_t count = last - first;
+        while (count > 0) {
+            size_t half = count / 2;
+            if (entries[first + half].first.compare(key, length) < 0) {
+                first += half + 1;
+                count -= half + 1;
+            } else {
+                count = half;
+            }
+        }
+        return first;
+    }
+
+    size_t Object::locate(const char* key, size_t length) const {
+        if (index.empty()) {
+            for (size_t position = 0; position < entries.size();
+                 position++) {
+                if (matches(position, key, length)) {
+                    return position;
+                }
+            }
+            return entries.size();
+        }
+
+        // Linear probing, the index is at most half full
+        size_t mask = index.size() - 1;
+        for (size_t slot = Key::hash(key, length) & mask; index[slot];
+             slot = (slot + 1) & mask) {
+            if (matches(index[slot] - 1, key, length)) {
+                return index[slot] - 1;
+            }
+        }
+        return entries.size();
+    }
+
+    void Object::indexEntry(size_t position) {
+#if defined(ELSON_ORDERED_OBJECTS)
+        if (entries.size() * 2 > index.size()) {
+            // Too full or not there yet
+            if (entries.size() > INDEX_SIZE) {
+                reindex();
+            }
+            return;
+        }
+
+        const Key& key = entries[position].first;
+        size_t mask = index.size() - 1;
+        size_t slot = Key::hash(key.data(), key.length()) & mask;
+        while (index[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        index[slot] = (uint32_t) (position + 1);
+#else
+        (void) position;
+#endif
+    }
+
+    void Object::reindex() {
+#if defined(ELSON_ORDERED_OBJECTS)
+        if (entries.size() <= INDEX_SIZE) {
+            index.clear();
+            return;
+        }
+
+        size_t capacity = 64;
+        while (capacity < entries.size() * 4) {
+            capacity *= 2;
+        }
+        index.assign(capacity, 0);
+
+        size_t mask = capacity - 1;
+        for (size_t position = 0; position < entries.size(); position++) {
+            const Key& key = entries[position].first;
+            size_t slot = Key::hash(key.data(), key.length()) & mask;
+            while (index[slot]) {
+                slot = (slot + 1) & mask;
+            }
+            index[slot] = (uint32_t) (position + 1);
+        }
+#endif
+    }
+
+    size_t Object::search(const char* key, size_t length, bool& found) {
+#if defined(ELSON_ORDERED_OBJECTS)
+        size_t position = locate(key, length);
+        found = matches(position, key, length);
+#else
+        finish();
+        size_t position = lowerBound(key, length, 0, merged);
+        found = matches(position, key, length);
+        if (!found && merged < entries.size()) {
+            position = lowerBound(key, length, merged, entries.size());
+            found = matches(position, key, length);
+        } else if (!found && entries.size() - position > MERGE_SIZE) {
+            // Too far from the end to insert in place, wait instead
+            position = entries.size();
+        }
+#endif
+        return position;
+    }
+
+    Object::iterator Object::iteratorAt(size_t position) {
+        if (position == entries.size()) {
+            return end();
+        }
+        const Key& key = entries[position].first;
+        if (position < merged) {
+            return cursor(position, lowerBound(key.data(), key.length(),
+                merged, entries.size()));
+        }
+        return cursor(lowerBound(key.data(), key.length(), 0, merged),
+            position);
+    }
+
+    Object::iterator Object::find(const char* key, size_t length) {
+        bool found;
+        size_t position = search(key, length, found);
+        return found ? iteratorAt(position) : end();
+    }
+
+    Object::const_iterator Object::find(const char* key,
+        size_t length) const {
+#if defined(ELSON_ORDERED_OBJECTS)
+        return cursor(locate(key, length), entries.size());
+#else
+        if (!sorted) {
+            // Latest entry first, like after sorting
+            for (size_t position = entries.size(); position-- > 0;) {
+                if (matches(position, key, length)) {
+                    return cursor(position, entries.size());
+                }
+            }
+            return end();
+        }
+        size_t position = lowerBound(key, length, 0, merged);
+        size_t waiting = lowerBound(key, length, merged, entries.size());
+        if (matches(position, key, length)
+            || matches(waiting, key, length)) {
+            return cursor(position, waiting);
+        }
+        return end();
+#endif
+    }
+
+    const Value* Object::get(const char* key, size_t length) const {
+#if defined(ELSON_ORDERED_OBJECTS)
+        size_t position = locate(key, length);
+#else
+        if (!sorted) {
+            const_iterator entry = find(key, length);
+            return entry == end() ? 0 : &entry->second;
+        }
+        size_t position = lowerBound(key, length, 0, merged);
+        if (!matches(position, key, length) && merged < entries.size()) {
+            position = lowerBound(key, length, merged, entries.size());
+        }
+#endif
+        return matches(position, key, length)
+            ? &entries[position].second : 0;
+    }
+
+    template <typename... Args>
+    size_t Object::emplace(size_t position, Args&&... key) {
+        // The key is built in place with the allocator of the object
+        entries.emplace(entries.begin() + position,
+            std::piecewise_construct,
+            std::forward_as_tuple(std::forward<Args>(key)...),
+            std::forward_as_tuple());
+        indexEntry(position);
+        return placed(position);
+    }
+
+    size_t Object::placed(size_t position) {
+#if defined(ELSON_ORDERED_OBJECTS)
+        merged = entries.size();
+        return position;
+#else
+        if (!sorted) {
+            // Appended by a parser, in document order until finish()
+            merged = entries.size();
+            return position;
+        }
+
+        // Entries at the end of the sorted ones join them
+        if (position < merged || (position == merged && (merged == 0
+            || entries[merged - 1].first < entries[merged].first))) {
+            merged++;
+            return position;
+        }
+
+        size_t waiting = entries.size() - merged;
+        if (waiting <= MERGE_SIZE || waiting * waiting <= merged * 4) {
+            return position;
+        }
+
+        // The entry ends up behind all smaller keys of both runs
+        const Key& key = entries[position].first;
+        size_t smaller = lowerBound(key.data(), key.length(), 0, merged)
+            + position - merged;
+        merge();
+        return smaller;
+#endif
+    }
+
+    void Object::merge() {
+        if (merged == entries.size()) {
+            return;
+        }
+
+        // Set the waiting entries aside and fill the gap from the
+        // back, so every entry moves once
+        Entries waiting(std::make_move_iterator(entries.begin() + merged),
+            std::make_move_iterator(entries.end()), entries.get_allocator());
+        size_t target = entries.size();
+        size_t first = merged;
+        size_t second = waiting.size();
+        while (second > 0) {
+            if (first > 0
+                && waiting[second - 1].first < entries[first - 1].first) {
+                entries[--target] = std::move(entries[--first]);
+            } else {
+                entries[--target] = std::move(waiting[--second]);
+            }
+        }
+        merged = entries.size();
+    }
+
+    Value& Object::lookup(const char* key, size_t length) {
+        bool found;
+        size_t position = search(key, length, found);
+        if (!found) {
+            position = emplace(position, key, length);
+        }
+        return entries[position].second;
+    }
+
+    Value& Object::lookup(Key&& key) {
+        bool found;
+        size_t position = search(key.data(), key.length(), found);
+        if (!found) {
+            position = emplace(position, std::move(key));
+        }
+        return entries[position].second;
+    }
+
+    Value& Object::operator[](const String& key) {
+        return lookup(key.data(), key.length());
+    }
+
+    Value& Object::operator[](const std::string& key) {
+        return lookup(key.data(), key.length());
+    }
+
+    Value& Object::operator[](const char* key) {
+        return lookup(key, strlen(key));
+    }
+
+    Value& Object::at(const char* key, size_t length) {
+        iterator entry = find(key, length);
+        if (entry == end()) {
+            ELSON_THROW(std::out_of_range("JSON::Object::at"));
+        }
+        return entry->second;
+    }
+
+    const Value& Object::at(const char* key, size_t length) const {
+        const Value* found = get(key, length);
+        if (!found) {
+            ELSON_THROW(std::out_of_range("JSON::Object::at"));
+        }
+        return *found;
+    }
+
+    std::pair<Object::iterator, bool> Object::insert(
+        const value_type& entry) {
+        bool found;
+        size_t position = search(
+            entry.first.data(), entry.first.length(), found);
+        if (!found) {
+            entries.insert(entries.begin() + position, entry);
+            indexEntry(position);
+            position = placed(position);
+        }
+        return std::make_pair(iteratorAt(position), !found);
+    }
+
+    std::pair<Object::iterator, bool> Object::insert(value_type&& entry) {
+        bool found;
+        size_t position = search(
+            entry.first.data(), entry.first.length(), found);
+        if (!found) {
+            entries.insert(entries.begin() + position, std::move(entry));
+            indexEntry(position);
+            position = placed(position);
+        }
+        return std::make_pair(iteratorAt(position), !found);
+    }
+
+    Object::iterator Object::erase(const_iterator position) {
+        // The neighbours of the removed entry in both runs follow it
+        size_t first = position.first - entries.data();
+        size_t second = position.second - entries.data();
+        size_t removed = position.current() - entries.data();
+        entries.erase(entries.begin() + removed);
+        if (removed < merged) {
+            merged--;
+            second--;
+        }
+        reindex();
+        return cursor(first, second);
+    }
+
+    Object::size_type Object::erase(const std::string& key) {
+        iterator entry = find(key);
+        if (entry == end()) {
+            return 0;
+        }
+        erase(entry);
+        return 1;
+    }
+
+    void Object::appending(const char* key, size_t length) {
+        merge();
+        if (sorted && !entries.empty()) {
+            sorted = entries.back().first.compare(key, length) < 0;
+        }
+        if (entries.capacity() == 0) {
+            entries.reserve(4);
+        }
+    }
+
+    Value& Object::append(const char* key, size_t length) {
+#if defined(ELSON_ORDERED_OBJECTS)
+        // Duplicate keys keep their first position
+        return lookup(key, length);
+#else
+        appending(key, length);
+        emplace(entries.size(), key, length);
+        return entries.back().second;
+#endif
+    }
+
+    Value& Object::append(Key&& key) {
+#if defined(ELSON_ORDERED_OBJECTS)
+        return lookup(std::move(key));
+#else
+        appending(key.data(), key.length());
+        emplace(entries.size(), std::move(key));
+        return entries.back().second;
+#endif
+    }
+
+    void Object::finish(std::vector<size_t>& order) {
+        if (sorted) {
+            return;
+        }
+        sorted = true;
+        size_t size = entries.size();
+
+        // Sort positions instead of moving entries around, the
+        // entries are moved into place once at the end.
+        size_t buffer[INSERTION_SORT_SIZE];
+        size_t* positions = buffer;
+        if (size > INSERTION_SORT_SIZE) {
+            order.resize(size);
+            positions = &order[0];
+        }
+        for (size_t position = 0; position < size; position++) {
+            positions[position] = position;
+        }
+
+        if (size <= INSERTION_SORT_SIZE) {
+            // Stable, equal keys keep their order
+            for (size_t next = 1; next < size; next++) {
+                size_t position = positions[next];
+                size_t target = next;
+                for (; target > 0 && entries[position].first
+                       < entries[positions[target - 1]].first; target--) {
+                    positions[target] = positions[target - 1];
+                }
+                positions[target] = position;
+            }
+        } else {
+            // Ties are broken by position to keep the sort stable
+            const Entries& sorting = entries;
+            std::sort(positions, positions + size,
+                [&sorting](size_t a, size_t b) {
+                    int result = sorting[a].first.compare(sorting[b].first);
+                    return result < 0 || (result == 0 && a < b);
+                });
+        }
+
+        // Move every entry to its place, cycle by cycle
+        for (size_t start = 0; start < size; start++) {
+            if (positions[start] == start) {
+                continue;
+            }
+            value_type entry(std::move(entries[start]));
+            size_t target = start;
+            while (positions[target] != start) {
+                size_t next = positions[target];
+                entries[target] = std::move(entries[next]);
+                positions[target] = target;
+                target = next;
+            }
+            entries[target] = std::move(entry);
+            positions[target] = target;
+        }
+
+        // Keep the last of every run of equal keys
+        size_t kept = 0;
+        for (size_t position = 0; position < size; position++) {
+            if (position + 1 < size && entries[position].first
+                == entries[position + 1].first) {
+                continue;
+            }
+            if (kept != position) {
+                entries[kept] = std::move(entries[position]);
+            }
+            kept++;
+        }
+        entries.erase(entries.begin() + kept, entries.end());
+        merged = entries.size();
+    }
+
+    template <typename T, typename... Args> T* Value::create(Args&&... args) {
+        Allocator<T> allocator(resource);
+        T* payload = allocator.allocate(1);
+        ::new((void*) payload) T(std::forward<Args>(args)...);
+        return payload;
+    }
+
+    template <typename T> void Value::destroy(T* payload) {
+        payload->~T();
+        Allocator<T>(resource).deallocate(payload, 1);
+    }
+
+    Value::Value(const char * val)
+    : type(JSON_STRING), resource(0) {
+        value.string = create<String>(val);
+    }
+
+    Value::Value(const std::string& val)
+    : type(JSON_STRING), resource(0) {
+        value.string = create<String>(val.data(), val.length());
+    }
+
+    Value::Value(const Array& val)
+    : type(JSON_ARRAY), resource(0) {
+        value.array = create<Array>(val, Allocator<Value>());
+    }
+
+    Value::Value(Array&& val)
+    : type(JSON_ARRAY), resource(0) {
+        value.array = create<Array>(std::move(val), Allocator<Value>());
+    }
+
+    Value::Value(std::initializer_list<Value> val)
+    : type(JSON_ARRAY), resource(0) {
+        value.array = create<Array>(val);
+    }
+
+    Value::Value(const Object& val)
+    : type(JSON_OBJECT), resource(0) {
+        value.object = create<Object>(val, Object::allocator_type());
+    }
+
+    Value::Value(Object&& val)
+    : type(JSON_OBJECT), resource(0) {
+        value.object = create<Object>(std::move(val), Object::allocator_type());
+    }
+
+    Value::Value(const Value& other)
+    : type(other.type), numberType(other.numberType), resource(0) {
+        copyPayload(other);
+    }
+
+    Value::Value(const Value& other, MemoryResource * resource)
+    : type(other.type), numberType(other.numberType), resource(resource) {
+        copyPayload(other);
+    }
+
+    Value::Value(Value&& other) noexcept
+    : type(other.type), numberType(other.numberType),
+      resource(other.resource), value(other.value) {
+        other.type = JSON_NULL;
+    }
+
+    Value& Value::operator=(const Value& other) {
+        if (this != &other) {
+            // Copy first: other may be a child of this value.
+            Value tmp(other, resource);
+            *this = std::move(tmp);
+        }
+        return *this;
+    }
+
+    Value& Value::operator=(Value&& other) {
+        if (this == &other) {
+            return *this;
+        }
+
+        if (other.resource != resource && other.hasPayload()) {
+            // Payloads can not move between resources
+            Value tmp(other, resource);
+            other.release();
+            return *this = std::move(tmp);
+        }
+
+        // Detach the payload before releasing the old one
+        // since other may live inside of this value.
+        JsonType otherType = other.type;
+        NumberType otherNumberType = other.numberType;
+        Payload otherValue = other.value;
+        other.type = JSON_NULL;
+
+        release();
+        type = otherType;
+        numberType = otherNumberType;
+        value = otherValue;
+        return *this;
+    }
+
+    void Value::release() {
+        if (!resource || !resource->isMonotonic()) {
+            switch (type) {
+            case JSON_STRING:
+                destroy(value.string);
+                break;
+            case JSON_ARRAY:
+                destroy(value.array);
+                break;
+            case JSON_OBJECT:
+                destroy(value.object);
+                break;
+            default:
+                break;
+            }
+        }
+        type = JSON_NULL;
+    }
+
+    void Value::copyPayload(const Value& other) {
+        switch (type) {
+        case JSON_STRING:
+            value.string = create<String>(*other.value.string,
+                Allocator<char>(resource));
+            break;
+        case JSON_ARRAY:
+            value.array = create<Array>(*other.value.array,
+                Allocator<Value>(resource));
+            break;
+        case JSON_OBJECT:
+            value.object = create<Object>(*other.value.object,
+                Object::allocator_type(resource));
+            break;
+        default:
+            value = other.value;
+            break;
+        }
+    }
+
+    void Value::adopt(MemoryResource * target) {
+        if (resource == target) {
+            return;
+        }
+        if (hasPayload()) {
+            Value tmp(*this, target);
+            release();
+            value = tmp.value;
+            type = tmp.type;
+            tmp.type = JSON_NULL;
+        }
+        resource = target;
+    }
     
     // Null value in literals:
     // Value val = {1,null,2};
     static Value null;
             
+    // Mutable access converts the value to the requested
+    // type if necessary.
     template<> Object& Value::asMutable() {
-        return std::get<JSON_OBJECT>(value);
+        if (type != JSON_OBJECT) {
+            release();
+            value.object = create<Object>(
+                Object::allocator_type(resource));
+            type = JSON_OBJECT;
+        }
+        return *value.object;
     }
             
     template<> Array& Value::asMutable() {
-        return std::get<JSON_ARRAY>(value);
+        if (type != JSON_ARRAY) {
+            release();
+            value.array = create<Array>(Allocator<Value>(resource));
+            type = JSON_ARRAY;
+        }
+        return *value.array;
+    }
+
+    template<> String& Value::asMutable() {
+        if (type != JSON_STRING) {
+            release();
+            value.string = create<String>(Allocator<char>(resource));
+            type = JSON_STRING;
+        }
+        return *value.string;
+    }
+
+    Value& Value::operator[](const std::string& key) {
+        // This may also be used for construction so
+        // ensure that the value is object type.
+        return asMutable<Object>()[key];
+    }
+
+    const Value* Value::find(const char* key, size_t length) const {
+        if (type != JSON_OBJECT) {
+            return 0;
+        }
+        return value.object->get(key, length);
+    }
+
+    const Value& Value::at(const char* key, size_t length) const {
+        const Value* found = find(key, length);
+        if (!found) {
+            ELSON_THROW(std::out_of_range("JSON::Value::at"));
+        }
+        return *found;
+    }
+
+    Value& Value::operator[](int index) {
+        return asMutable<Array>()[index];
+    }
+
+    void Value::push_back(const Value& val) {
+        asMutable<Array>().push_back(val);
     }
             
     // Template specializations for Value::as
     // JSON_NUMBER
-    template <> double Value::as() const throw(ConversionException) {
+    template <typename T> T Value::asNumeric() const {
         switch(type) {
         case JSON_NUMBER:
             // Number -> Number
-            return std::get<JSON_NUMBER>(value);
+            switch (numberType) {
+            case NUMBER_INTEGER:
+                return (T) value.integer;
+            case NUMBER_UNSIGNED:
+                return (T) value.uinteger;
+            default:
+                return (T) value.number;
+            }
         case JSON_STRING:
             // String -> Number
-            return fromString<double>(std::get<JSON_STRING>(value));
+            return (T) fromString<double>(
+                std::string(value.string->data(), value.string->length()));
         case JSON_BOOL:
             // Bool -> Number
-            return std::get<JSON_BOOL>(value) ? 1 : 0;
+            return value.boolean ? 1 : 0;
         default:
-            throw(ConversionException(type, typenames[JSON_NUMBER]));
+            ELSON_THROW(ConversionException(type, typenames[JSON_NUMBER]));
         }
     }
-    
-    // JSON_NUMBER
-    // Simply cast to other numeric types
-    template <> int Value::as() const
-    throw(ConversionException) { return (int) as<double>(); }
-    
-    template <> unsigned int Value::as() const
-    throw(ConversionException) { return (unsigned int) std::abs(as<double>()); }
-    
-    template <> long Value::as() const 
-    throw(ConversionException) { return (long) as<double>(); }
+
+    template <> double Value::as() const {
+        return asNumeric<double>();
+    }
+
+    template <> float Value::as() const {
+        return asNumeric<float>();
+    }
+
+    // Integers are read directly, floats are truncated
+    template <> int Value::as() const { return asNumeric<int>(); }
+
+    template <> long Value::as() const { return asNumeric<long>(); }
+
+    template <> long long Value::as() const { return asNumeric<long long>(); }
+
+    // Unsigned conversions yield the magnitude of the number
+    template <> unsigned long long Value::as() const {
+        if (type == JSON_NUMBER && numberType == NUMBER_INTEGER) {
+            return value.integer < 0
+                ? 0 - (unsigned long long) value.integer
+                : (unsigned long long) value.integer;
+        } else if (type == JSON_NUMBER && numberType == NUMBER_UNSIGNED) {
+            return value.uinteger;
+        }
+        return (unsigned long long) std::abs(as<double>());
+    }
+
+    template <> unsigned long Value::as() const {
+        return (unsigned long) as<unsigned long long>();
+    }
+
+    template <> unsigned int Value::as() const {
+        return (unsigned int) as<unsigned long long>();
+    }
     
     // JSON_STRING
-    template <> std::string Value::as() const throw(ConversionException) {
+    template <> std::string Value::as() const {
         switch(type) {
         case JSON_STRING:
             // String -> String
-            return std::get<JSON_STRING>(value);
+            return std::string(value.string->data(), value.string->length());
         case JSON_NUMBER:
             // Number -> String
-            return toString<double>(std::get<JSON_NUMBER>(value));
+            return numberToString();
         case JSON_BOOL:
             // Bool -> String
-            return std::get<JSON_BOOL>(value) ? "true" : "false";
+            return value.boolean ? "true" : "false";
         case JSON_NULL:
             // Null -> String
             return typenames[JSON_NULL];
         default:
-            throw(ConversionException(type, typenames[JSON_STRING]));
+            ELSON_THROW(ConversionException(type, typenames[JSON_STRING]));
         }
     }
     
     // JSON_BOOL
-    template <> bool Value::as() const throw(ConversionException) {
+    template <> bool Value::as() const {
         switch(type) {
         case JSON_BOOL:
             // Bool -> Bool
-            return std::get<JSON_BOOL>(value);
+            return value.boolean;
         case JSON_NUMBER:
             // Number -> Bool
             // Interpret everything < 0 as false otherwise as true
-            return std::get<JSON_NUMBER>(value) < 0 ? false : true;
+            switch (numberType) {
+            case NUMBER_INTEGER:
+                return value.integer < 0 ? false : true;
+            case NUMBER_UNSIGNED:
+                return true;
+            default:
+                return value.number < 0 ? false : true;
+            }
         default:
-            throw(ConversionException(type, typenames[JSON_BOOL]));
+            ELSON_THROW(ConversionException(type, typenames[JSON_BOOL]));
         }
     }   
     
     // JSON_ARRAY
-    template <> Array Value::as() const throw(ConversionException) {
-        switch(type) {
-        case JSON_ARRAY:
-            // Array -> Array
-            return std::get<JSON_ARRAY>(value);
-        default:
-            throw(ConversionException(type, typenames[JSON_ARRAY]));
-        }
+    template <> Array Value::as() const {
+        return asArray();
     }
     
     // JSON_OBJECT
-    template <> Object Value::as() const throw(ConversionException) {
-        switch(type) {
-        case JSON_OBJECT:
-            // Object -> Object
-            return std::get<JSON_OBJECT>(value);
-        default:
-            throw(ConversionException(type, typenames[JSON_OBJECT]));
-        }
+    template <> Object Value::as() const {
+        return asObject();
     }    
+
+    const String& Value::asString() const {
+        if (type != JSON_STRING) {
+            ELSON_THROW(ConversionException(type, typenames[JSON_STRING]));
+        }
+        return *value.string;
+    }
+
+    const Array& Value::asArray() const {
+        if (type != JSON_ARRAY) {
+            ELSON_THROW(ConversionException(type, typenames[JSON_ARRAY]));
+        }
+        return *value.array;
+    }
+
+    const Object& Value::asObject() const {
+        if (type != JSON_OBJECT) {
+            ELSON_THROW(ConversionException(type, typenames[JSON_OBJECT]));
+        }
+        return *value.object;
+    }
 }
 
 #endif // VALUE_H
@@ -0,0 +1,355 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+#include "Exceptions.hpp"
+#include "Number.hpp"
+#include "Sink.hpp"
+#include "Strings.hpp"
+#include "Value.hpp"
+
+namespace JSON {
+    /**
+     * Writes a document as it is produced, without building a Value
+     * tree first:
+     *
+     *     writer.beginObject();
+     *     writer.key("ids").beginArray().value(1).value(2).endArray();
+     *     writer.endObject();
+     *
+     * Calls that would not produce well formed JSON (a key outside of
+     * an object, a value without a key, mismatched ends or a second
+     * root value) throw a WriterException. With an indent greater
+     * than 0 the output is formatted like PrettyPrinter does. The sink
+     * is flushed once the root value is complete.
+     */
+    class Writer {
+        public:
+            Writer(Sink& out, unsigned int indent = 0,
+                Escaping escaping = ESCAPE_MINIMAL)
+            : out(out), indentDepth(indent), escaping(escaping),
+              currentIndent(0), hasKey(false), done(false) {
+                // Typical nesting does not allocate while writing
+                frames.reserve(16);
+            }
+
+            Writer& beginObject();
+            Writer& endObject();
+            Writer& beginArray();
+            Writer& endArray();
+
+            Writer& key(const char * key, size_t length);
+
+            Writer& key(const char * key) {
+                return this->key(key, strlen(key));
+            }
+
+            Writer& key(const std::string& key) {
+                return this->key(key.data(), key.length());
+            }
+
+            Writer& value(const char * string, size_t length);
+
+            Writer& value(const char * string) {
+                return value(string, strlen(string));
+            }
+
+            Writer& value(const std::string& string) {
+                return value(string.data(), string.length());
+            }
+
+            Writer& value(int number) {
+                return writeInteger(number);
+            }
+
+            Writer& value(long number) {
+                return writeInteger(number);
+            }
+
+            Writer& value(long long number) {
+                return writeInteger(number);
+            }
+
+            Writer& value(unsigned int number) {
+                return writeUnsigned(number);
+            }
+
+            Writer& value(unsigned long number) {
+                return writeUnsigned(number);
+            }
+
+            Writer& value(unsigned long long number) {
+                return writeUnsigned(number);
+            }
+
+            Writer& value(double number);
+            Writer& value(bool boolean);
+            Writer& null();
+
+            // Write a whole tree at the current position
+            Writer& value(const Value& value);
+
+            // True once the root value is complete
+            bool complete() const {
+                return done;
+            }
+
+            // Start over with the next document
+            void reset() {
+                frames.clear();
+                currentIndent = 0;
+                hasKey = false;
+                done = false;
+            }
+
+        private:
+            Writer(const Writer&);
+            Writer& operator=(const Writer&);
+
+            // An open array or object
+            struct Frame {
+                bool object;
+                bool empty;
+            };
+
+            bool pretty() const {
+                return indentDepth > 0;
+            }
+
+            // Separators and checks around every value
+            void beforeValue();
+            void afterValue();
+
+            void writeIndent();
+            void writeString(const char * string, size_t length);
+            Writer& writeInteger(int64_t number);
+            Writer& writeUnsigned(uint64_t number);
+
+            Sink& out;
+            unsigned int indentDepth;
+            Escaping escaping;
+            unsigned int currentIndent;
+
+            std::vector<Frame> frames;
+
+            // A key was written and waits for its value
+            bool hasKey;
+
+            // The root value is complete
+            bool done;
+    };
+
+    void Writer::beforeValue() {
+        if (frames.empty()) {
+            if (done) {
+                ELSON_THROW(WriterException("a document has a single root value"));
+            }
+            return;
+        }
+
+        Frame& top = frames.back();
+        if (top.object) {
+            if (!hasKey) {
+                ELSON_THROW(WriterException("values in objects need a key"));
+            }
+            hasKey = false;
+            return;
+        }
+
+        if (!top.empty) {
+            if (pretty()) {
+                out.write(", ", 2);
+            } else {
+                out.put(',');
+            }
+        }
+        top.empty = false;
+    }
+
+    void Writer::afterValue() {
+        if (frames.empty()) {
+            done = true;
+            out.flush();
+        }
+    }
+
+    void Writer::writeIndent() {
+        for (unsigned int i = 0; i < currentIndent; ++i) {
+            out.put(' ');
+        }
+    }
+
+    void Writer::writeString(const char* string, size_t length) {
+        out.put('"');
+        strings::escape(string, string + length, out, escaping);
+        out.put('"');
+    }
+
+    Writer& Writer::beginObject() {
+        beforeValue();
+        if (pretty()) {
+            out.write("{\n", 2);
+            currentIndent += indentDepth;
+        } else {
+            out.put('{');
+        }
+        Frame frame = { true, true };
+        frames.push_back(frame);
+        return *this;
+    }
+
+    Writer& Writer::endObject() {
+        if (frames.empty() || !frames.back().object) {
+            ELSON_THROW(WriterException("endObject without an open object"));
+        }
+        if (hasKey) {
+            ELSON_THROW(WriterException("key without a value"));
+        }
+        frames.pop_back();
+
+        if (pretty()) {
+            currentIndent -= indentDepth;
+            out.put('\n');
+            writeIndent();
+        }
+        out.put('}');
+        afterValue();
+        return *this;
+    }
+
+    Writer& Writer::beginArray() {
+        beforeValue();
+        out.put('[');
+        Frame frame = { false, true };
+        frames.push_back(frame);
+        return *this;
+    }
+
+    Writer& Writer::endArray() {
+        if (frames.empty() || frames.back().object) {
+            ELSON_THROW(WriterException("endArray without an open array"));
+        }
+        frames.pop_back();
+        out.put(']');
+        afterValue();
+        return *this;
+    }
+
+    Writer& Writer::key(const char* key, size_t length) {
+        if (frames.empty() || !frames.back().object) {
+            ELSON_THROW(WriterException("keys are only allowed in objects"));
+        }
+        if (hasKey) {
+            ELSON_THROW(WriterException("key without a value"));
+        }
+
+        Frame& top = frames.back();
+        if (pretty()) {
+            if (!top.empty) {
+                out.write(",\n", 2);
+            }
+            writeIndent();
+            writeString(key, length);
+            out.write(": ", 2);
+        } else {
+            if (!top.empty) {
+                out.put(',');
+            }
+            writeString(key, length);
+            out.put(':');
+        }
+        top.empty = false;
+        hasKey = true;
+        return *this;
+    }
+
+    Writer& Writer::value(const char* string, size_t length) {
+        beforeValue();
+        writeString(string, length);
+        afterValue();
+        return *this;
+    }
+
+    Writer& Writer::writeInteger(int64_t number) {
+        beforeValue();
+        char buffer[number::FORMAT_BUFFER_SIZE];
+        out.write(buffer, number::format(number, buffer) - buffer);
+        afterValue();
+        return *this;
+    }
+
+    Writer& Writer::writeUnsigned(uint64_t number) {
+        beforeValue();
+        char buffer[number::FORMAT_BUFFER_SIZE];
+        out.write(buffer, number::format(number, buffer) - buffer);
+        afterValue();
+        return *this;
+    }
+
+    Writer& Writer::value(double number) {
+        beforeValue();
+        char buffer[number::FORMAT_BUFFER_SIZE];
+        out.write(buffer, number::format(number, buffer) - buffer);
+        afterValue();
+        return *this;
+    }
+
+    Writer& Writer::value(bool boolean) {
+        beforeValue();
+        if (boolean) {
+            out.write("true", 4);
+        } else {
+            out.write("false", 5);
+        }
+        afterValue();
+        return *this;
+    }
+
+    Writer& Writer::null() {
+        beforeValue();
+        out.write("null", 4);
+        afterValue();
+        return *this;
+    }
+
+    Writer& Writer::value(const Value& value) {
+        switch (value.getType()) {
+        case JSON_OBJECT:
+            beginObject();
+            for (const auto& pair : value.asObject()) {
+                key(pair.first.data(), pair.first.length());
+                this->value(pair.second);
+            }
+            return endObject();
+        case JSON_ARRAY:
+            beginArray();
+            for (const auto& item : value.asArray()) {
+                this->value(item);
+            }
+            return endArray();
+        case JSON_STRING: {
+            const String& string = value.asString();
+            return this->value(string.data(), string.length());
+        }
+        case JSON_NUMBER:
+            switch (value.getNumberType()) {
+            case NUMBER_INTEGER:
+                return writeInteger(value.as<int64_t>());
+            case NUMBER_UNSIGNED:
+                return writeUnsigned(value.as<uint64_t>());
+            default:
+                return this->value(value.as<double>());
+            }
+        case JSON_BOOL:
+            return this->value(value.as<bool>());
+        default:
+            return null();
+        }
+    }
+}
+
+#endif // WRITER_H
@@ -1,10 +1,45 @@
 #define CATCH_CONFIG_RUNNER
 #include <iostream>
+#include <fstream>
 #include "./Catch/catch.hpp"
 #include "../include/Elson.hpp"
+#include "../include/Ndjson.hpp"
 
 using namespace JSON;
 
+// Counts heap allocations for the memory tests
+static size_t heapAllocations = 0;
+
+void* operator new(size_t size) {
+    heapAllocations++;
+    void* memory = malloc(size ? size : 1);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+// All forms must be replaced, C++14 and later call the sized ones
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    free(memory);
+}
+
 TEST_CASE( "base/types", "Basic JSON Data types" ) {
     Value val = 5;
     REQUIRE(val.is(JSON_NUMBER));
@@ -111,6 +146,295 @@ TEST_CASE( "base/types", "Basic JSON Data types" ) {
     REQUIRE(val[key].as<unsigned int>() == 42);
 }
 
+TEST_CASE( "base/value", "Value storage and ownership") {
+    REQUIRE(sizeof(Value) <= 24);
+
+    Value val = Object { { "a", { 1, 2, 3 } }, { "b", "text" } };
+    Value copy = val;
+    copy["a"][0] = 42;
+    copy["b"] = "changed";
+    REQUIRE(val["a"][0].as<int>() == 1);
+    REQUIRE(val["b"].as<std::string>() == "text");
+    REQUIRE(copy["a"][0].as<int>() == 42);
+
+    Value moved = std::move(copy);
+    REQUIRE(moved.is(JSON_OBJECT));
+    REQUIRE(copy.is(JSON_NULL));
+
+    // Assign a child to its own parent
+    val = val["a"];
+    REQUIRE(val.is(JSON_ARRAY));
+    REQUIRE(val.as<Array>().size() == 3);
+    val = std::move(val[1]);
+    REQUIRE(val.is(JSON_NUMBER));
+    REQUIRE(val.as<int>() == 2);
+
+    val = val;
+    REQUIRE(val.as<int>() == 2);
+
+    // Mutable access switches the type
+    val = "text";
+    val["key"] = true;
+    REQUIRE(val.is(JSON_OBJECT));
+    REQUIRE(val["key"].as<bool>());
+
+    val = 1;
+    val.push_back(2);
+    REQUIRE(val.is(JSON_ARRAY));
+    REQUIRE(val.as<Array>().size() == 1);
+}
+
+TEST_CASE( "base/object", "Flat objects") {
+    // Duplicates in the initializer list keep the first value
+    Object object { { "b", 2 }, { "a", 1 }, { "c", 3 }, { "a", 4 } };
+    REQUIRE(object.size() == 3);
+    REQUIRE(object["a"].as<int>() == 1);
+
+    object["ab"] = 5;
+    object[std::string("")] = 6;
+    object[String("b\0", 2)] = 7;
+    REQUIRE(object.size() == 6);
+
+    std::string keys;
+    for (Object::const_iterator entry = object.begin();
+         entry != object.end(); ++entry) {
+        keys += "[" + std::string(entry->first.data(),
+            entry->first.length()) + "]";
+    }
+#if defined(ELSON_ORDERED_OBJECTS)
+    // Iteration is in insertion order
+    REQUIRE(keys == std::string("[b][a][c][ab][][b\0]", 19));
+#else
+    // Iteration is ordered by key like std::string compares
+    REQUIRE(keys == std::string("[][a][ab][b][b\0][c]", 19));
+#endif
+
+    REQUIRE(object.find("ab", 2) != object.end());
+    REQUIRE(object.find("ab", 1)->second.as<int>() == 1);
+    REQUIRE(object.find(std::string("d")) == object.end());
+    REQUIRE(object.count("c") == 1);
+    REQUIRE(object.at("b").as<int>() == 2);
+    REQUIRE_THROWS_AS(object.at("d"), std::out_of_range);
+
+    REQUIRE_FALSE(object.insert(Object::value_type("c", 8)).second);
+    REQUIRE(object.insert(Object::value_type("d", 8)).second);
+    REQUIRE(object.erase("a") == 1);
+    REQUIRE(object.erase("a") == 0);
+    REQUIRE(object.erase(std::string("b\0", 2)) == 1);
+    REQUIRE(object.size() == 5);
+
+    Printer printer;
+    Value value = std::move(object);
+    value["e"] = Object { { "y", true }, { "x", null } };
+#if defined(ELSON_ORDERED_OBJECTS)
+    REQUIRE(printer.print(value) == "{\"b\":2,\"c\":3,\"ab\":5,\"\":6,\"d\":8,"
+        "\"e\":{\"y\":true,\"x\":null}}");
+#else
+    REQUIRE(printer.print(value) == "{\"\":6,\"ab\":5,\"b\":2,\"c\":3,\"d\":8,"
+        "\"e\":{\"x\":null,\"y\":true}}");
+#endif
+
+    // Wide objects however the keys arrive
+    Value wide;
+    std::vector<std::string> inserted;
+    for (int key = 999; key >= 0; key -= 2) {
+        inserted.push_back(toString(key));
+    }
+    for (int key = 0; key < 1000; key += 2) {
+        inserted.push_back(toString(key));
+    }
+    for (size_t index = 0; index < inserted.size(); index++) {
+        wide[inserted[index]] = inserted[index];
+    }
+#if !defined(ELSON_ORDERED_OBJECTS)
+    std::sort(inserted.begin(), inserted.end());
+#endif
+    Object& entries = wide.asMutable<Object>();
+    REQUIRE(entries.size() == 1000);
+    bool expected = true;
+    Object::const_iterator entry = entries.begin();
+    for (size_t index = 0; index < entries.size(); index++, ++entry) {
+        expected = expected && entry->first.c_str() == inserted[index]
+            && entry->second.as<std::string>() == inserted[index]
+            && entries.find(inserted[index]) == entry;
+    }
+    REQUIRE(expected);
+    REQUIRE(entry == entries.end());
+
+    for (int key = 0; key < 1000; key += 3) {
+        entries.erase(toString(key));
+    }
+    size_t found = 0;
+    for (int key = 0; key < 1000; key++) {
+        found += entries.count(toString(key));
+    }
+    REQUIRE(found == 666);
+    REQUIRE(entries.size() == 666);
+
+    // Keys added in random order, erased and looked up behave like
+    // in a std::map, also while some of them wait to be merged
+    Object& mixed = wide.asMutable<Object>();
+    mixed.clear();
+    std::map<std::string, int> reference;
+    unsigned int seed = 3;
+    bool same = true;
+    for (int step = 0; step < 20000; step++) {
+        seed = seed * 1103515245 + 12345;
+        std::string key = toString((seed >> 8) % 3000);
+        switch ((seed >> 24) % 4) {
+        case 0:
+        case 1:
+            mixed[key] = step;
+            reference[key] = step;
+            break;
+        case 2:
+            same = same && mixed.insert(Object::value_type(key.c_str(), step))
+                .second == reference.insert(std::make_pair(key, step)).second;
+            break;
+        default:
+            Object::iterator entry = mixed.find(key);
+            same = same && (entry != mixed.end()) == (reference.erase(key) == 1);
+            if (entry != mixed.end()) {
+                entry = mixed.erase(entry);
+#if !defined(ELSON_ORDERED_OBJECTS)
+                // Erasing returns the next key
+                std::map<std::string, int>::iterator next
+                    = reference.lower_bound(key);
+                same = same && (next == reference.end() ? entry == mixed.end()
+                    : entry->first.c_str() == next->first);
+#endif
+            }
+        }
+
+        if (step % 1000 == 999) {
+            const Object& view = mixed;
+            std::map<std::string, int> seen;
+            std::string previous;
+            for (Object::const_iterator entry = view.begin();
+                 entry != view.end(); ++entry) {
+                std::string current = entry->first.c_str();
+#if !defined(ELSON_ORDERED_OBJECTS)
+                same = same && (seen.empty() || previous < current);
+#endif
+                seen[current] = entry->second.as<int>();
+                previous = current;
+                same = same && view.find(current) == entry
+                    && mixed.find(current) == entry;
+            }
+            same = same && seen == reference && view.size() == reference.size();
+        }
+    }
+    REQUIRE(same);
+
+    // Parsers complete objects, the last of duplicate keys wins
+    Parser parser;
+    for (int size = 8; size <= 128; size *= 4) {
+        std::string json = "{";
+        for (int key = size - 1; key >= 0; key--) {
+            json += "\"" + toString(key % (size / 2)) + "\":"
+                + toString(key) + ",";
+        }
+        json += "\"x\":{\"b\":1,\"a\":2}}";
+        parser.parse(wide, json);
+        REQUIRE(wide.as<Object>().size() == (size_t) size / 2 + 1);
+        REQUIRE(wide["0"].as<int>() == 0);
+        REQUIRE(wide["1"].as<int>() == 1);
+#if defined(ELSON_ORDERED_OBJECTS)
+        REQUIRE(printer.print(wide["x"]) == "{\"b\":1,\"a\":2}");
+#else
+        REQUIRE(printer.print(wide["x"]) == "{\"a\":2,\"b\":1}");
+#endif
+    }
+
+    // Objects of a failed parse still find their keys
+    REQUIRE_THROWS(parser.parse(wide, "{\"b\":1,\"a\":2,\"b\":3,"));
+    const Object partial = wide.as<Object>();
+    REQUIRE(partial.find(std::string("b"))->second.as<int>() == 3);
+    REQUIRE(wide["a"].as<int>() == 2);
+    REQUIRE(wide["b"].as<int>() == 3);
+#if defined(ELSON_ORDERED_OBJECTS)
+    REQUIRE(printer.print(wide) == "{\"b\":3,\"a\":2}");
+#else
+    REQUIRE(printer.print(wide) == "{\"a\":2,\"b\":3}");
+#endif
+}
+
+TEST_CASE( "base/access", "Read only access without copies") {
+    Value val = Object { { "list", { 1, "two" } }, { "text", "a string" } };
+    const Value& object = val;
+
+    REQUIRE(&object.asObject() == &val.asMutable<Object>());
+    REQUIRE(&object.at("list").asArray() == &val["list"].asMutable<Array>());
+    REQUIRE(object.at("text").asString() == "a string");
+    REQUIRE_THROWS_AS(object.asArray(), ConversionException);
+    REQUIRE_THROWS_AS(object.at("text").asObject(), ConversionException);
+    REQUIRE_THROWS_AS(object.at("list").asString(), ConversionException);
+
+    // Printing does not copy the tree
+    Value deep = "leaf";
+    for (int depth = 0; depth < 100; depth++) {
+        Value parent;
+        parent["a key that does not fit inline"] = depth;
+        parent["list"].push_back(std::move(deep));
+        deep = std::move(parent);
+    }
+    Printer printer;
+    PrettyPrinter pretty;
+    std::string expected = printer.print(deep);
+    size_t before = heapAllocations;
+    std::string printed = printer.print(deep);
+    size_t allocations = heapAllocations - before;
+    REQUIRE(printed == expected);
+    REQUIRE(allocations < 100);
+
+    before = heapAllocations;
+    printed = pretty.print(deep);
+    allocations = heapAllocations - before;
+    REQUIRE(allocations < 100);
+}
+
+TEST_CASE( "base/find", "Const lookup without modification") {
+    Value val;
+    Parser parser;
+    parser.parse(val, "{\"a key that does not fit inline\": [1, 2], "
+        "\"b\": null, \"c\": {\"d\": true}}");
+    const Value& object = val;
+
+    // Lookups neither allocate nor insert missing keys
+    size_t before = heapAllocations;
+    const Value* found = object.find("a key that does not fit inline");
+    const Value* missing = object.find("another key that does not fit");
+    bool contains = object.contains("b") && !object.contains("b", 0);
+    const Value& nested = object.at("c").at("d");
+    size_t allocations = heapAllocations - before;
+
+    REQUIRE(allocations == 0);
+    REQUIRE(found != 0);
+    REQUIRE(found->as<Array>().size() == 2);
+    REQUIRE(missing == 0);
+    REQUIRE(contains);
+    REQUIRE(nested.as<bool>());
+    REQUIRE(object.find(std::string("b"))->is(JSON_NULL));
+    REQUIRE(object.as<Object>().size() == 3);
+
+    // Other types and missing keys
+    REQUIRE(object.at("c").at("d").find("d") == 0);
+    REQUIRE_THROWS_AS(object.at("d"), std::out_of_range);
+    REQUIRE_THROWS_AS(object.at("c").at(std::string("a")), std::out_of_range);
+    REQUIRE(object.as<Object>().size() == 3);
+
+    Object& entries = val.asMutable<Object>();
+    REQUIRE(entries.find("b") != entries.end());
+    REQUIRE(entries.at("c", 1).contains("d"));
+    REQUIRE(entries.count("x") == 0);
+#if defined(ELSON_HAS_STRING_VIEW)
+    std::string_view key("c and more", 1);
+    REQUIRE(object.contains(key));
+    REQUIRE(object.at(key).find(std::string_view("d"))->as<bool>());
+    REQUIRE(entries.find(key) != entries.end());
+#endif
+}
+
 TEST_CASE( "base/parse", "Basic parsing") {
     Parser p;
     Printer printer;
@@ -123,7 +447,7 @@ TEST_CASE( "base/parse", "Basic parsing") {
     REQUIRE_NOTHROW(p.parse(val, ""));
     REQUIRE(val.is(JSON_NULL));
 
-    auto numbers = {"0", "1", "1E3", "1e-3", "0.5", "-.05e-07"};
+    auto numbers = {"0", "1", "1E3", "1e-3", "0.5", "-0.05e-07", "1E+2"};
     
     for (auto number: numbers) {
         REQUIRE_NOTHROW(p.parse(val, number));
@@ -131,6 +455,14 @@ TEST_CASE( "base/parse", "Basic parsing") {
     }
     
     REQUIRE_THROWS(p.parse(val, "-0.5w4"));
+
+    // Strict JSON number grammar
+    auto invalidNumbers = {"-.05e-07", ".5", "01", "-01", "1.", "1.e3",
+                           "1e", "1e+", "--1", "0x10", "1.5.5"};
+
+    for (auto number: invalidNumbers) {
+        REQUIRE_THROWS(p.parse(val, number));
+    }
     
     std::vector<std::string> strings = {
         "\"\"",
@@ -145,7 +477,7 @@ TEST_CASE( "base/parse", "Basic parsing") {
     }
     
     std::map<std::string, std::string> escapes = {
-        { "\"\\\\\"", "\"\\\"" },
+        { "\"\\\\\"", "\"\\\\\"" },
         { "\"\\/\"", "\"/\"" },
         { "\"\\u5022\"", "\"倢\"" }
     };
@@ -251,6 +583,409 @@ TEST_CASE( "base/parse", "Basic parsing") {
     REQUIRE_THROWS(p.parse(val, "{[]}"));
 }
 
+TEST_CASE( "base/integers", "Exact 64 bit integers") {
+    Parser p;
+    Printer printer;
+    Value val;
+
+    val = 9007199254740993L;
+    REQUIRE(val.isInteger());
+    REQUIRE(val.as<long>() == 9007199254740993L);
+    REQUIRE(val.as<std::string>() == "9007199254740993");
+
+    val = 18446744073709551615ULL;
+    REQUIRE(val.getNumberType() == NUMBER_UNSIGNED);
+    REQUIRE(val.as<unsigned long long>() == 18446744073709551615ULL);
+
+    val = 42u;
+    REQUIRE(val.getNumberType() == NUMBER_INTEGER);
+    REQUIRE(val.as<unsigned int>() == 42);
+
+    val = -3;
+    REQUIRE(val.as<unsigned int>() == 3);
+    REQUIRE(!val.as<bool>());
+
+    val = 2.5;
+    REQUIRE(!val.isInteger());
+    REQUIRE(val.as<int>() == 2);
+
+    std::vector<std::string> integers = {
+        "0",
+        "-1",
+        "12345678901234567",
+        "9223372036854775807",
+        "-9223372036854775808",
+        "18446744073709551615"
+    };
+
+    for (auto number: integers) {
+        REQUIRE_NOTHROW(p.parse(val, number));
+        REQUIRE(val.isInteger());
+        REQUIRE(printer.print(val) == number);
+    }
+
+    REQUIRE_NOTHROW(p.parse(val, "{\"id\": 1152921504606846977}"));
+    REQUIRE(val["id"].as<long>() == 1152921504606846977L);
+
+    REQUIRE_NOTHROW(p.parse(val, "18446744073709551616"));
+    REQUIRE(val.is(JSON_NUMBER));
+    REQUIRE(!val.isInteger());
+
+    REQUIRE_NOTHROW(p.parse(val, "-0"));
+    REQUIRE(!val.isInteger());
+
+    REQUIRE_NOTHROW(p.parse(val, "1.0"));
+    REQUIRE(!val.isInteger());
+    REQUIRE(val.as<int>() == 1);
+
+    REQUIRE_THROWS(p.parse(val, "-"));
+    REQUIRE_THROWS(p.parse(val, "1-2"));
+}
+
+TEST_CASE( "base/floats", "Correctly rounded number parsing") {
+    Parser p;
+    Value val;
+
+    // Inputs covering the fast path, Eisel-Lemire, truncated
+    // mantissas and the slow path for subnormals.
+    std::vector<std::string> numbers = {
+        "97.03125000001",
+        "-122.41941550000001",
+        "0.1",
+        "3.141592653589793238462643383279",
+        "1.7976931348623157e308",
+        "2.2250738585072014e-308",
+        "4.9406564584124654e-324",
+        "123456789012345678901234567890",
+        "9007199254740993.0",
+        "1e22",
+        "1e23",
+        "0.000000000000000000000000000001",
+        "7.2057594037927933e16",
+        "2.4703282292062328e-324"
+    };
+
+    for (auto number: numbers) {
+        REQUIRE_NOTHROW(p.parse(val, number));
+        REQUIRE(val.as<double>() == strtod(number.c_str(), 0));
+    }
+
+    REQUIRE_NOTHROW(p.parse(val, "1e400"));
+    REQUIRE(val.as<double>() == std::numeric_limits<double>::infinity());
+
+    REQUIRE_NOTHROW(p.parse(val, "-1e-400"));
+    REQUIRE(val.as<double>() == 0);
+    REQUIRE(std::signbit(val.as<double>()));
+
+    REQUIRE_NOTHROW(p.parse(val, "[1.5,-2.25e1]"));
+    REQUIRE(val[0].as<double>() == 1.5);
+    REQUIRE(val[1].as<double>() == -22.5);
+}
+
+TEST_CASE( "base/print", "Round trip number formatting") {
+    Parser p;
+    Printer printer;
+    Value val;
+
+    std::map<double, std::string> expected = {
+        { 97.03125000001, "97.03125000001" },
+        { 0.1, "0.1" },
+        { -1.5, "-1.5" },
+        { 3.0, "3" },
+        { 1e20, "100000000000000000000" },
+        { 1e21, "1e+21" },
+        { 1.5e300, "1.5e+300" },
+        { 0.000001, "0.000001" },
+        { 1e-7, "1e-7" },
+        { 5e-324, "5e-324" },
+        { 1.7976931348623157e308, "1.7976931348623157e+308" },
+        { -0.0, "-0" },
+        // Not the shortest digits, but they read back the same
+        { 8.0653e124, "8.0653000000000005e+124" }
+    };
+
+    for (auto pair: expected) {
+        REQUIRE(printer.print(pair.first) == pair.second);
+    }
+
+    val = std::numeric_limits<double>::infinity();
+    REQUIRE(printer.print(val) == "null");
+
+    // Everything printed must parse back to the same double
+    double samples[] = { 0.3, 2.0 / 3.0, 1e-300, 123456.789e10, 1e23,
+                         -122.41941550000001, 4.35e-10, 9007199254740993.0,
+                         8.0653e124 };
+    for (double sample: samples) {
+        REQUIRE_NOTHROW(p.parse(val, printer.print(sample)));
+        REQUIRE(val.as<double>() == sample);
+    }
+}
+
+TEST_CASE( "print/sink", "Printing to sinks") {
+    Value val;
+    for (int index = 0; index < 1000; index++) {
+        val["list"].push_back(Object {
+            { "a string that is long", "a value that is even longer" },
+            { "number", index }
+        });
+    }
+    Printer printer;
+    PrettyPrinter pretty;
+    std::string expected = printer.print(val);
+    REQUIRE(expected.size() > 64 * 1024);
+
+    // Strings are appended to
+    std::string out = "prefix";
+    {
+        StringSink sink(out);
+        printer.print(val, sink);
+        REQUIRE(out == "prefix" + expected);
+        printer.print(Value(1), sink);
+    }
+    REQUIRE(out == "prefix" + expected + "1");
+
+    // Fixed buffers do not allocate and drop what does not fit
+    std::vector<char> buffer(expected.size());
+    BufferSink fits(&buffer[0], buffer.size());
+    size_t before = heapAllocations;
+    printer.print(val, fits);
+    size_t allocations = heapAllocations - before;
+    REQUIRE(allocations == 0);
+    REQUIRE(!fits.truncated());
+    REQUIRE(std::string(&buffer[0], fits.size()) == expected);
+
+    char small[16];
+    BufferSink truncated(small, sizeof(small));
+    printer.print(val, truncated);
+    REQUIRE(truncated.truncated());
+    REQUIRE(truncated.size() == sizeof(small));
+    REQUIRE(truncated.required() == expected.size());
+    REQUIRE(std::string(small, sizeof(small)) == expected.substr(0, 16));
+
+    // Buffered sinks pass the output on in blocks
+    std::string collected;
+    size_t blocks = 0;
+    CallbackSink callback([&] (const char* data, size_t length) {
+        collected.append(data, length);
+        blocks++;
+    });
+    printer.print(val, callback);
+    REQUIRE(collected == expected);
+    REQUIRE(blocks < expected.size() / 4096);
+
+    std::ostringstream stream;
+    pretty.print(val, stream);
+    REQUIRE(stream.str() == pretty.print(val));
+
+    FILE* file = tmpfile();
+    REQUIRE(file != 0);
+    {
+        FileSink sink(file);
+        printer.print(val, sink);
+        fflush(file);
+        FileSink descriptor(fileno(file));
+        printer.print(Value("x"), descriptor);
+    }
+    std::vector<char> contents(expected.size() + 8);
+    rewind(file);
+    size_t length = fread(&contents[0], 1, contents.size(), file);
+    fclose(file);
+    REQUIRE(std::string(&contents[0], length) == expected + "\"x\"");
+
+    FileSink invalid(-1);
+    REQUIRE_THROWS_AS(printer.print(val, invalid), WriteException);
+}
+
+TEST_CASE( "print/escape", "Escaping printed strings") {
+    Printer printer;
+    Printer ascii(ESCAPE_ASCII);
+    Parser parser;
+    FastParser fast;
+    Value val;
+
+    val = std::string("\"\\/\b\f\n\r\t\x01\x1f\x7f", 11);
+    REQUIRE(printer.print(val)
+        == "\"\\\"\\\\/\\b\\f\\n\\r\\t\\u0001\\u001f\x7f\"");
+    val = std::string("a\0b", 3);
+    REQUIRE(printer.print(val) == "\"a\\u0000b\"");
+
+    // Keys are escaped as well
+    val = Object { { "a\"b", 1 } };
+    REQUIRE(printer.print(val) == "{\"a\\\"b\":1}");
+    PrettyPrinter pretty(4, ESCAPE_ASCII);
+    val = Object { { "\xc3\xa4", "\n" } };
+    REQUIRE(pretty.print(val) == "{\n    \"\\u00e4\": \"\\n\"\n}");
+
+    // Beyond ASCII, with surrogate pairs for the astral planes
+    val = "\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80";
+    REQUIRE(printer.print(val) == "\"\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80\"");
+    REQUIRE(ascii.print(val) == "\"\\u00e4\\u20ac\\ud83d\\ude00\"");
+    val = "\xff\xe2\x82 \xed\xa0\x80";
+    REQUIRE(ascii.print(val) == "\"\\ufffd\\ufffd\\ufffd \\ufffd\\ufffd\\ufffd\"");
+
+    // Surrogate pairs are decoded by all parsers, lone ones are errors
+    const char* pair = "\"\\ud83d\\ude00\"";
+    parser.parse(val, pair);
+    REQUIRE(val.as<std::string>() == "\xf0\x9f\x98\x80");
+    fast.parse(val, pair);
+    REQUIRE(val.as<std::string>() == "\xf0\x9f\x98\x80");
+    StreamParser stream(val);
+    for (const char* p = pair; *p; p++) {
+        stream.feed(p, 1);
+    }
+    stream.finish();
+    REQUIRE(val.as<std::string>() == "\xf0\x9f\x98\x80");
+    const char* lone[] = { "\"\\ud83d\"", "\"\\ud83dx\"", "\"\\ud83d\\n\"",
+                           "\"\\ud83d\\u0041\"", "\"\\ude00\"" };
+    for (const char* json : lone) {
+        REQUIRE_THROWS_AS(parser.parse(val, json), InvalidCodePointException);
+        StreamParser failing(val);
+        REQUIRE_THROWS_AS(failing.feed(json), InvalidCodePointException);
+    }
+
+    // Printed strings parse back to themselves
+    const char* pieces[] = { "a", "\"", "\\", "\n", "\x01", "\x1f", " ",
+                             "\xc3\xa4", "\xe2\x82\xac", "\xf0\x9f\x98\x80" };
+    std::string text;
+    unsigned int seed = 7;
+    bool roundTrip = true, onlyAscii = true;
+    for (int i = 0; i < 2000; i++) {
+        seed = seed * 1103515245 + 12345;
+        text += (seed >> 16) % 4 ? "x" : pieces[(seed >> 20) % 10];
+        if (i % 97 == 0) {
+            Value original = text;
+            std::string printed = ascii.print(original);
+            for (size_t index = 0; index < printed.size(); index++) {
+                onlyAscii = onlyAscii && (unsigned char) printed[index] < 0x80;
+            }
+            parser.parse(val, printed);
+            roundTrip = roundTrip && val.as<std::string>() == text;
+            fast.parse(val, printer.print(original));
+            roundTrip = roundTrip && val.as<std::string>() == text;
+        }
+    }
+    REQUIRE(roundTrip);
+    REQUIRE(onlyAscii);
+}
+
+TEST_CASE( "print/writer", "Streaming writer") {
+    Value val = Object {
+        { "a", { 1, -2, 2.5, true, null, "text\n",
+                 Object { { "b", Array() }, { "c", Object() } } } },
+        { "d", Object { { "e", 18446744073709551615ULL } } },
+        { "f\"", Array { Array(), Array { 1 } } }
+    };
+    Printer printer;
+    PrettyPrinter pretty;
+
+    // Trees written through the writer print the same
+    std::string compact, formatted;
+    StringSink compactSink(compact), formattedSink(formatted);
+    Writer writer(compactSink);
+    Writer prettyWriter(formattedSink, 4);
+    writer.value(val);
+    prettyWriter.value(val);
+    REQUIRE(writer.complete());
+    REQUIRE(compact == printer.print(val));
+    REQUIRE(formatted == pretty.print(val));
+
+    // Written step by step without a tree and without allocating
+    char buffer[256];
+    BufferSink fixed(buffer, sizeof(buffer));
+    Writer direct(fixed);
+    size_t before = heapAllocations;
+    direct.beginObject()
+        .key("id").value(42)
+        .key(std::string("name")).value("\xc3\xa4\"")
+        .key("scores").beginArray().value(1.5).value(2u).null().endArray()
+        .key("flags").beginObject().key("on").value(false).endObject()
+        .endObject();
+    size_t allocations = heapAllocations - before;
+    REQUIRE(allocations == 0);
+    REQUIRE(std::string(buffer, fixed.size()) == "{\"id\":42,\"name\":\"\xc3\xa4\\\"\","
+        "\"scores\":[1.5,2,null],\"flags\":{\"on\":false}}");
+
+    std::string ascii;
+    StringSink asciiSink(ascii);
+    Writer escaping(asciiSink, 0, ESCAPE_ASCII);
+    escaping.beginArray().value("\xc3\xa4").endArray();
+    REQUIRE(ascii == "[\"\\u00e4\"]");
+
+    // Documents must be well formed
+    std::string out;
+    StringSink sink(out);
+    Writer checked(sink);
+    REQUIRE_THROWS_AS(checked.key("a"), WriterException);
+    REQUIRE_THROWS_AS(checked.endObject(), WriterException);
+    checked.beginObject();
+    REQUIRE_THROWS_AS(checked.value(1), WriterException);
+    REQUIRE_THROWS_AS(checked.endArray(), WriterException);
+    checked.key("a");
+    REQUIRE_THROWS_AS(checked.key("b"), WriterException);
+    REQUIRE_THROWS_AS(checked.endObject(), WriterException);
+    checked.beginArray();
+    REQUIRE_THROWS_AS(checked.key("b"), WriterException);
+    REQUIRE_THROWS_AS(checked.endObject(), WriterException);
+    checked.endArray().endObject();
+    REQUIRE(checked.complete());
+    REQUIRE_THROWS_AS(checked.value(1), WriterException);
+    REQUIRE(out == "{\"a\":[]}");
+
+    checked.reset();
+    checked.value("next");
+    REQUIRE(out == "{\"a\":[]}\"next\"");
+}
+
+TEST_CASE( "base/buffer", "Parsing from caller owned buffers") {
+    Parser p;
+    Printer printer;
+    Value val;
+
+    // Not null terminated, the trailing garbage is outside the range
+    const char buffer[] = { '[', '1', ',', '"', 'a', '"', ']', 'x' };
+    REQUIRE_NOTHROW(p.parse(val, buffer, 7));
+    REQUIRE(printer.print(val) == "[1,\"a\"]");
+
+    REQUIRE_THROWS(p.parse(val, buffer, 8));
+    REQUIRE_THROWS(p.parse(val, buffer, 6));
+
+    // Numbers ending at the end of the buffer
+    const char number[] = { '4', '2', '5' };
+    REQUIRE_NOTHROW(p.parse(val, number, 2));
+    REQUIRE(val.as<int>() == 42);
+
+    std::string source = "{\"a\": [true, null]}";
+    REQUIRE_NOTHROW(p.parse(val, source.data(), source.size()));
+    REQUIRE(val["a"][0].as<bool>());
+}
+
+TEST_CASE( "base/file", "Parsing memory mapped files") {
+    const char* path = "parse_file_test.json";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "{\"a\": [1, 2,\n \"x\"]}";
+    }
+
+    Parser parser;
+    FastParser fast;
+    Value val;
+    parser.parseFile(val, path);
+    REQUIRE(val["a"][2].as<std::string>() == "x");
+
+    val = null;
+    fast.parseFile(val, path);
+    REQUIRE(val["a"][1].as<int>() == 2);
+
+    // Empty files leave the value alone like empty strings do
+    { std::ofstream file(path, std::ios::binary | std::ios::trunc); }
+    parser.parseFile(val, path);
+    REQUIRE(val["a"][1].as<int>() == 2);
+
+    remove(path);
+    REQUIRE_THROWS_AS(parser.parseFile(val, path), FileException);
+    REQUIRE_THROWS_AS(fast.parseFile(val, path), FileException);
+}
+
 TEST_CASE( "base/unicode", "Unicode escape handling") {
     Parser p;
     Printer printer;
@@ -284,6 +1019,499 @@ TEST_CASE( "base/unicode", "Unicode escape handling") {
     REQUIRE_THROWS(p.parse(val, "\"\\u\""));
 }
 
+TEST_CASE( "base/strings", "String and key parsing") {
+    Parser p;
+    Value val;
+
+    std::string blob(100000, 'x');
+    REQUIRE_NOTHROW(p.parse(val, "\"" + blob + "\""));
+    REQUIRE(val.as<std::string>() == blob);
+
+    REQUIRE_NOTHROW(p.parse(val, "\"a\\nb\\tc\\\"d\\\\e\\u0041\""));
+    REQUIRE(val.as<std::string>() == "a\nb\tc\"d\\eA");
+
+    // Escapes in keys
+    REQUIRE_NOTHROW(p.parse(val, "{\"k\\\"ey\": 1, \"\\u00e4\": 2}"));
+    REQUIRE(val["k\"ey"].as<int>() == 1);
+    REQUIRE(val["\u00e4"].as<int>() == 2);
+
+    REQUIRE_THROWS(p.parse(val, "\"abc"));
+    REQUIRE_THROWS(p.parse(val, "\"abc\\"));
+    REQUIRE_THROWS(p.parse(val, "{\"abc: 1}"));
+    REQUIRE_THROWS(p.parse(val, "nul"));
+    REQUIRE_THROWS(p.parse(val, "[nulL]"));
+    REQUIRE_THROWS(p.parse(val, "tru"));
+    REQUIRE_THROWS(p.parse(val, "falsy"));
+    REQUIRE_THROWS(p.parse(val, "[truex]"));
+}
+
+TEST_CASE( "simd/scan", "Vectorized scanning kernels") {
+    // Compare the dispatched kernels against the scalar ones for
+    // all offsets and lengths around the vector widths.
+    const char alphabet[] = { 'a', ' ', '\n', '\t', '\r', '"', '\\',
+                              (char) 0x01, (char) 0x1F, (char) 0xC3 };
+    std::string input;
+    unsigned int seed = 1;
+    for (int i = 0; i < 4096; i++) {
+        seed = seed * 1103515245 + 12345;
+        // Long runs of one character class with occasional others
+        char code = (seed >> 16) % 8 == 0
+            ? alphabet[(seed >> 20) % sizeof(alphabet)]
+            : (i / 40 % 2 ? 'x' : ' ');
+        input.push_back(code);
+    }
+
+    const char* data = input.data();
+    for (size_t begin = 0; begin < 200; begin++) {
+        for (size_t size = 0; size < 100; size += 7) {
+            const char* end = data + begin + size;
+            REQUIRE(simd::findStringSpecial(data + begin, end)
+                == simd::findStringSpecialScalar(data + begin, end));
+            REQUIRE(simd::findStringSpecialOrNonAscii(data + begin, end)
+                == simd::findStringSpecialOrNonAsciiScalar(data + begin, end));
+
+            REQUIRE(simd::skipWhitespace(data + begin, end)
+                == simd::skipWhitespaceScalar(data + begin, end));
+            REQUIRE(simd::countNewlines(data + begin, end)
+                == simd::countNewlinesScalar(data + begin, end));
+        }
+    }
+
+    // Sums over several rounds of 255 blocks
+    std::string lines(100000, '\n');
+    REQUIRE(simd::countNewlines(lines.data(), lines.data() + lines.length())
+        == 100000);
+
+    Parser p;
+    Value val;
+    std::string pretty = "{\n\t\"a\" :\r\n    [ 1,\n        2 ]  \n}\n";
+    REQUIRE_NOTHROW(p.parse(val, pretty));
+    REQUIRE(val["a"][1].as<int>() == 2);
+
+    // Raw control characters and non JSON whitespace are rejected
+    REQUIRE_THROWS(p.parse(val, "\"a\tb\""));
+    REQUIRE_THROWS(p.parse(val, "\"a\nb\""));
+    REQUIRE_THROWS(p.parse(val, "[1,\f2]"));
+}
+
+// Parse with the given parser and describe the outcome
+template <typename P> std::string outcome(P& parser, const std::string& input) {
+    Printer printer;
+    Value val;
+    try {
+        parser.parse(val, input);
+        return printer.print(val);
+    } catch (UnexpectedEndOfInputException& e) {
+        return std::string("end: ") + e.what();
+    } catch (UnexpectedCharactersException& e) {
+        return std::string("chars: ") + e.what();
+    } catch (ParseException& e) {
+        return std::string("syntax: ") + e.what();
+    } catch (std::exception& e) {
+        return std::string("other: ") + e.what();
+    }
+}
+
+// Valid and invalid documents to compare parsers with
+std::vector<std::string> parseSamples() {
+    std::vector<std::string> inputs = {
+        "", " ", "0", "-1.5e3", "true", "false", "null", "\"a\"",
+        "[]", "{}", "[1,2,3]", "{\"a\":{\"b\":[1,{\"c\":null}]}}",
+        "  [ 1 , \"x\" , { \"k\" : [ ] } ]  ",
+        "\"esc \\\" , : [ ] { } \\\\\"", "[\"\\\\\",1]",
+        "{\"a\\\"b\":1}", "\"\\u0041\\u00e4\"",
+        "[1,]", "[,1]", "[1 2]", "{\"a\" 1}", "{\"a\":}", "{1:2}",
+        "[", "]", "{", "[1,", "{\"a\"", "{\"a\":", "\"abc", "tru",
+        "truex", "[truex]", "nul", "[1]x", "[1]]", "\"a\"b", "[\"a\"b]",
+        "[1\"a\"]", "-", "01", "1.", "[-0.5w4]", "\"\\x\"", "\"a\tb\"",
+        "\n\n[1,\n2,\n]", "{\"a\":1,}", "[[],[{}],[[]]]", "[{},]",
+        "[tx]", "[nulx]", "\"\\u12g4\"", "\"\\u12", "[\n\"\\u00\"]",
+        "{\n  \"a\": [1,\n   2 x]}", "[1,\n  01]", "\n  -", "[\n  1]\n x",
+        "\"\\ud83d\\ude00\"", "\"\\ud83d\\u.e00\"", "\"\\ud83d\\u0041\"",
+        "[\"\\ud83d\\u00\"]", "\"\\ud83d\\n\"", "\"\\ud83d\\", "\"\\ude00\""
+    };
+
+    // Strings, escapes and numbers crossing 64 byte blocks
+    for (int shift = 0; shift < 70; shift++) {
+        std::string padding(shift, ' ');
+        inputs.push_back(padding + "[\"" + std::string(shift, 'x')
+            + "\\\\\\\"\", 12345, true, {\"k\\\\\": null}]");
+        inputs.push_back(padding + "[\"" + std::string(shift, '\\')
+            + "\"]");
+    }
+    return inputs;
+}
+
+TEST_CASE( "fast/parse", "Two stage parser matches the parser") {
+    Parser parser;
+    FastParser fast;
+
+    for (auto input: parseSamples()) {
+        INFO(input);
+        REQUIRE(outcome(fast, input) == outcome(parser, input));
+    }
+}
+
+// Describe the outcome of tryParse like outcome() does for parse
+std::string tryOutcome(Parser& parser, const std::string& input) {
+    Value val;
+    ParseError error = parser.tryParse(val, input);
+    switch (error.code) {
+    case PARSE_OK:
+        return Printer().print(val);
+    case PARSE_UNEXPECTED_END:
+        return std::string("end: ")
+            + UnexpectedEndOfInputException(error).what();
+    case PARSE_UNEXPECTED_CHARACTERS:
+        return std::string("chars: ")
+            + UnexpectedCharactersException(error).what();
+    case PARSE_SYNTAX_ERROR:
+        return std::string("syntax: ") + ParseException(error).what();
+    default:
+        return "other";
+    }
+}
+
+TEST_CASE( "base/tryparse", "Parsing without exceptions") {
+    Parser parser;
+
+    // Fails where parse throws
+    std::vector<std::string> inputs = parseSamples();
+    inputs.push_back("\"\\ud800\"");
+    for (auto input: inputs) {
+        INFO(input);
+        std::string expected = outcome(parser, input);
+        if (expected.compare(0, 6, "other:") == 0) {
+            expected = "other";
+        }
+        REQUIRE(tryOutcome(parser, input) == expected);
+    }
+
+    // Offsets, lines and columns of the offending byte
+    Value val;
+    ParseError error = parser.tryParse(val, "{\"a\": [1,\n  2,\n  x]}");
+    REQUIRE(bool(error));
+    REQUIRE(error.code == PARSE_SYNTAX_ERROR);
+    REQUIRE(error.offset == 17);
+    REQUIRE(error.line == 3);
+    REQUIRE(error.column == 3);
+    REQUIRE(std::string(error.message()) == "Syntax error");
+
+    error = parser.tryParse(val, "[1,\n2");
+    REQUIRE(error.code == PARSE_UNEXPECTED_END);
+    REQUIRE(error.offset == 5);
+    REQUIRE(error.line == 2);
+    REQUIRE(error.column == 2);
+
+    error = parser.tryParse(val, "[\"\\ud83d\"]");
+    REQUIRE(error.code == PARSE_INVALID_CODE_POINT);
+    REQUIRE(error.offset == 4);
+
+    error = parser.tryParse(val, "{} {}");
+    REQUIRE(error.code == PARSE_UNEXPECTED_CHARACTERS);
+    REQUIRE(error.offset == 3);
+    REQUIRE(error.column == 4);
+
+    // Valid input and reuse after an error
+    error = parser.tryParse(val, "{\"a\": [1, 2]}");
+    REQUIRE_FALSE(bool(error));
+    REQUIRE(val["a"][1].as<int>() == 2);
+    REQUIRE(parser.tryParse(val, "").code == PARSE_OK);
+
+    Document document;
+    REQUIRE(parser.tryParse(document, "[1, 2").code == PARSE_UNEXPECTED_END);
+    REQUIRE(parser.tryParse(document, "[1, 2]").code == PARSE_OK);
+    REQUIRE(document.getRoot()[1].as<int>() == 2);
+
+    // The error path does not allocate
+    Handler ignore;
+    const char* garbage = "{\"key\": [1, 2, {\"x\": tru}]}";
+    parser.tryParse(ignore, garbage);
+    size_t before = heapAllocations;
+    error = parser.tryParse(ignore, garbage);
+    size_t allocations = heapAllocations - before;
+    REQUIRE(error.code == PARSE_SYNTAX_ERROR);
+    REQUIRE(allocations == 0);
+}
+
+// Records the events as a compact string
+class Recorder : public Handler {
+public:
+    void startObject()                  { events += "{"; }
+    void key(const std::string& key)    { events += "k:" + key + " "; }
+    void endObject()                    { events += "}"; }
+    void startArray()                   { events += "["; }
+    void endArray()                     { events += "]"; }
+    void string(const std::string& s)   { events += "s:" + s + " "; }
+    void number(double)                 { events += "d "; }
+    void integer(int64_t)               { events += "i "; }
+    void unsignedInteger(uint64_t)      { events += "u "; }
+    void boolean(bool b)                { events += b ? "t " : "f "; }
+    void null()                         { events += "n "; }
+
+    std::string events;
+};
+
+TEST_CASE( "sax/handler", "Parsers report events to a handler") {
+    const char* input =
+        "{\"a\": [1, -2, 1.5, 18446744073709551615], "
+        "\"b\": {\"c\": \"x\", \"d\": [true, false, null]}, \"e\": {}}";
+    const std::string expected =
+        "{k:a [i i d u ]k:b {k:c s:x k:d [t f n ]}k:e {}}";
+
+    Parser parser;
+    Recorder slow;
+    parser.parse(slow, input);
+    REQUIRE(slow.events == expected);
+
+    FastParser fast;
+    Recorder quick;
+    fast.parse(quick, input);
+    REQUIRE(quick.events == expected);
+
+    // The default handler ignores everything
+    Handler ignore;
+    parser.parse(ignore, input);
+    fast.parse(ignore, input);
+    REQUIRE_THROWS_AS(parser.parse(ignore, "[1,"),
+        UnexpectedEndOfInputException);
+    REQUIRE_THROWS_AS(fast.parse(ignore, "[1,"),
+        UnexpectedEndOfInputException);
+}
+
+// Feeds the input to a StreamParser in chunks of the given size
+struct ChunkedParser {
+    ChunkedParser(size_t size) : size(size) { }
+
+    void parse(Value& val, const std::string& input) {
+        StreamParser stream(val);
+        for (size_t offset = 0; offset < input.length(); offset += size) {
+            stream.feed(input.substr(offset, size));
+        }
+        stream.finish();
+    }
+
+    size_t size;
+};
+
+TEST_CASE( "stream/parse", "Streaming parser matches the parser") {
+    Parser parser;
+    std::vector<std::string> inputs = parseSamples();
+    inputs.push_back("[\"\\u00e4\\n\", 12.5e-3, -7, 18446744073709551615]");
+    inputs.push_back("{\"k\": [\"\\ud800\"]}");
+    inputs.push_back("[1.5.3]");
+    inputs.push_back("1-2");
+
+    for (auto input: inputs) {
+        INFO(input);
+        std::string expected = outcome(parser, input);
+        for (size_t size = 1; size <= input.length(); size++) {
+            INFO(size);
+            ChunkedParser chunked(size);
+            REQUIRE(outcome(chunked, input) == expected);
+        }
+    }
+
+    // A parser can be reused after finish() and after reset()
+    Value val;
+    StreamParser stream(val);
+    stream.feed("{\"a\": [1, 2", 11);
+    stream.feed("]}");
+    stream.finish();
+    REQUIRE(val["a"][1].as<int>() == 2);
+
+    stream.feed("[tr");
+    REQUIRE_THROWS_AS(stream.feed("ux]"), ParseException);
+    stream.reset();
+    stream.feed("[true]");
+    stream.finish();
+    REQUIRE(val[0].as<bool>());
+
+    // Events are reported as soon as the data allows
+    Recorder recorder;
+    StreamParser events(recorder);
+    events.feed("[\"ab");
+    REQUIRE(recorder.events == "[");
+    events.feed("c\", 4");
+    REQUIRE(recorder.events == "[s:abc ");
+    events.feed("2]");
+    REQUIRE(recorder.events == "[s:abc i ]");
+    events.finish();
+}
+
+// Position reported by a parser for invalid input
+template <typename P> std::string position(P& parser, const std::string& input) {
+    Value val;
+    try {
+        parser.parse(val, input);
+    } catch (InputException& e) {
+        return std::to_string(e.offset()) + " " + std::to_string(e.line())
+            + ":" + std::to_string(e.column());
+    }
+    return "";
+}
+
+TEST_CASE( "base/errors", "Positions of parse errors") {
+    Parser parser;
+    FastParser fast;
+    ChunkedParser bytes(1), chunks(5);
+
+    const char* inputs[][2] = {
+        { "{\n  \"a\": [1,\n    2 x]}", "19 3:7" },
+        { "[\n\ttrux]", "6 2:5" },
+        { "\r\n[\"a\\q\"]", "6 2:5" },
+        { "[\n\n", "3 3:1" },
+        { "[1] \n 2", "6 2:2" },
+        { "[\"\\ud83d\"]", "4 1:5" },
+        { "[\"\\ud83d\\u.e00\"]", "4 1:5" }
+    };
+    for (auto& input: inputs) {
+        INFO(input[0]);
+        REQUIRE(position(parser, input[0]) == input[1]);
+        REQUIRE(position(fast, input[0]) == input[1]);
+        REQUIRE(position(bytes, input[0]) == input[1]);
+        REQUIRE(position(chunks, input[0]) == input[1]);
+    }
+
+    Value val;
+    try {
+        parser.parse(val, "[1,\n2,\n]");
+    } catch (ParseException& e) {
+        REQUIRE(e.code() == PARSE_SYNTAX_ERROR);
+        REQUIRE(std::string(e.what()) == "Syntax error in line 3, column 1");
+    }
+}
+
+// Arrays or objects nested depth times
+std::string nested(size_t depth, bool objects) {
+    std::string json;
+    for (size_t level = 0; level < depth; level++) {
+        json += objects ? "{\"a\":" : "[";
+    }
+    json += "1";
+    for (size_t level = 0; level < depth; level++) {
+        json += objects ? "}" : "]";
+    }
+    return json;
+}
+
+TEST_CASE( "base/depth", "Nesting depth limit") {
+    Parser parser;
+    FastParser fast;
+    ChunkedParser chunks(7);
+    REQUIRE(parser.getMaxDepth() == default_max_depth);
+
+    for (bool objects: { false, true }) {
+        std::string limit = nested(default_max_depth, objects);
+        std::string deeper = nested(default_max_depth + 1, objects);
+        size_t offset = default_max_depth * (objects ? 5 : 1);
+        INFO(objects);
+
+        Value val;
+        REQUIRE(parser.tryParse(val, limit).code == PARSE_OK);
+        REQUIRE(outcome(fast, limit) == outcome(parser, limit));
+        REQUIRE(outcome(chunks, limit) == outcome(parser, limit));
+
+        try {
+            parser.parse(val, deeper);
+            FAIL("Nesting limit not enforced");
+        } catch (NestingDepthException& e) {
+            REQUIRE(e.offset() == offset);
+        }
+        REQUIRE_THROWS_AS(fast.parse(val, deeper), NestingDepthException);
+        REQUIRE_THROWS_AS(chunks.parse(val, deeper), NestingDepthException);
+        REQUIRE(position(fast, deeper) == position(parser, deeper));
+        REQUIRE(position(chunks, deeper) == position(parser, deeper));
+
+        ParseError error = parser.tryParse(val, deeper);
+        REQUIRE(error.code == PARSE_TOO_DEEP);
+        REQUIRE(error.offset == offset);
+    }
+
+    // Hostile input fails fast instead of exhausting the stack
+    std::string hostile(1000000, '[');
+    Value val;
+    REQUIRE(parser.tryParse(val, hostile).code == PARSE_TOO_DEEP);
+    REQUIRE_THROWS_AS(fast.parse(val, hostile), NestingDepthException);
+
+    // The limit can be raised, the parser itself does not recurse
+    Handler ignore;
+    std::string deep = nested(200000, false);
+    parser.setMaxDepth(deep.length());
+    REQUIRE(parser.tryParse(ignore, deep).code == PARSE_OK);
+    fast.setMaxDepth(deep.length());
+    fast.parse(ignore, deep);
+    StreamParser stream(ignore);
+    stream.setMaxDepth(deep.length());
+    stream.feed(deep);
+    stream.finish();
+
+    parser.setMaxDepth(2);
+    REQUIRE(parser.tryParse(val, "[[1], {\"a\": 2}, []]").code == PARSE_OK);
+    REQUIRE(parser.tryParse(val, "[[[]]]").code == PARSE_TOO_DEEP);
+    try {
+        parser.parse(val, "[[\n{}]]");
+        FAIL("Nesting limit not enforced");
+    } catch (NestingDepthException& e) {
+        REQUIRE(e.code() == PARSE_TOO_DEEP);
+        REQUIRE(std::string(e.what()) == "Nesting deeper than 2 in line 2, column 1");
+    }
+}
+
+TEST_CASE( "ndjson/read", "Parallel newline delimited JSON") {
+    // Small chunks so that every worker gets some
+    std::string input;
+    for (int index = 0; index < 1000; index++) {
+        if (index == 500) {
+            input += "\n";
+        } else if (index % 300 == 7) {
+            input += "{\"broken\": }\n";
+        } else {
+            input += "{\"id\": " + std::to_string(index) + "}\r\n";
+        }
+    }
+
+    NdjsonReader reader(4, 64);
+
+    std::vector<size_t> order;
+    std::vector<NdjsonError> errors = reader.read(input,
+        [&](size_t index, Value& val) {
+            REQUIRE(val["id"].as<size_t>() == index);
+            order.push_back(index);
+        });
+
+    REQUIRE(order.size() == 995);
+    REQUIRE(std::is_sorted(order.begin(), order.end()));
+
+    REQUIRE(errors.size() == 4);
+    REQUIRE(errors[0].index == 7);
+    REQUIRE(errors[1].index == 307);
+    REQUIRE(input.compare(errors[1].offset, 11, "{\"broken\": ") == 0);
+
+    // Unordered delivery sees the same records
+    std::mutex mutex;
+    size_t sum = 0;
+    errors = reader.readUnordered(input, [&](size_t index, Value&) {
+        std::lock_guard<std::mutex> lock(mutex);
+        sum += index;
+    });
+    REQUIRE(errors.size() == 4);
+    REQUIRE(sum == 999 * 1000 / 2 - 7 - 307 - 500 - 607 - 907);
+
+    // Exceptions from the callback stop the read
+    REQUIRE_THROWS_AS(reader.read(input, [](size_t index, Value&) {
+        if (index == 100) {
+            throw std::runtime_error("stop");
+        }
+    }), std::runtime_error);
+
+    // Last line without a newline
+    errors = reader.read("1\n2", [&](size_t index, Value& val) {
+        REQUIRE(val.as<size_t>() == index + 1);
+    });
+    REQUIRE(errors.empty());
+}
+
 TEST_CASE( "utils/base", "Utils") {
     Value val = Object {
         { "a", 1 },
@@ -321,6 +1549,11 @@ TEST_CASE( "utils/base", "Utils") {
     PropertyList l3;
     traverse(l3, val);
     REQUIRE(l3.size() == 3);
+
+    // Properties point into the object
+    *l3[1].second = "changed";
+    REQUIRE(l3[1].first == "c");
+    REQUIRE(val["b"]["c"].as<std::string>() == "changed");
 }
 
 TEST_CASE("memory/heap", "heap allocation") {
@@ -341,6 +1574,199 @@ TEST_CASE("memory/heap", "heap allocation") {
     delete pr;
 }
 
+TEST_CASE("memory/document", "Arena allocated documents") {
+    std::string json = "{\"name\": \"a string that is too long to be stored inline\", "
+        "\"list\": [1, 2.5, true, null, {\"a key that is long enough to allocate\": []}]}";
+
+    Parser parser;
+    Document doc;
+    parser.parse(doc, json);
+
+    Value& root = doc.getRoot();
+    REQUIRE(root.getResource() == &doc.getArena());
+    REQUIRE(root["list"][4].getResource() == &doc.getArena());
+    REQUIRE(root["name"].as<std::string>()
+        == "a string that is too long to be stored inline");
+    REQUIRE(doc.getArena().used() > 0);
+
+    // Copies leave the arena, values put into the document enter it
+    Value copy = root["list"];
+    REQUIRE(copy.getResource() == 0);
+    root["extra"] = Value(Object { { "nested", "another string that is long" } });
+    REQUIRE(root["extra"].getResource() == &doc.getArena());
+    root["list"].push_back(copy);
+    REQUIRE(root["list"][5].getResource() == &doc.getArena());
+
+    // Move construction keeps the arena, move assignment to a heap
+    // value copies
+    Value moved(std::move(root["extra"]));
+    REQUIRE(moved.getResource() == &doc.getArena());
+    Value owned;
+    owned = std::move(moved);
+    REQUIRE(owned.getResource() == 0);
+
+    doc.reset();
+    REQUIRE(doc.getRoot().is(JSON_NULL));
+    REQUIRE(owned["nested"].as<std::string>() == "another string that is long");
+    REQUIRE(copy[4].is(JSON_OBJECT));
+    REQUIRE(copy[1].as<double>() == 2.5);
+
+    // Once the arena is large enough reuse does not allocate
+    FastParser fast;
+    for (int round = 0; round < 3; round++) {
+        size_t before = heapAllocations;
+        parser.parse(doc, json);
+        fast.parse(doc, json);
+        size_t allocations = heapAllocations - before;
+        if (round == 2) {
+            REQUIRE(allocations == 0);
+        }
+    }
+
+    Printer printer;
+    Value expected;
+    parser.parse(expected, json);
+    REQUIRE(printer.print(doc.getRoot()) == printer.print(expected));
+}
+
+// Heap memory that keeps track of what is in use
+class CountingResource : public MemoryResource {
+public:
+    CountingResource() : bytes(0) { }
+
+    void* allocate(size_t size, size_t) {
+        bytes += size;
+        return ::operator new(size);
+    }
+
+    void deallocate(void* memory, size_t size, size_t) {
+        bytes -= size;
+        ::operator delete(memory);
+    }
+
+    size_t bytes;
+};
+
+TEST_CASE("memory/resource", "Values allocating from a memory resource") {
+    std::string json = "{\"name\": \"a string that is too long to be stored inline\", "
+        "\"list\": [1, {\"a key that is long enough to allocate\": [\"x\"]}]}";
+
+    CountingResource resource;
+    {
+        Value root(&resource);
+        Parser parser;
+        parser.parse(root, json);
+        REQUIRE(resource.bytes > 0);
+        REQUIRE(root["list"][1].getResource() == &resource);
+
+        // Copies into a resource are deep
+        size_t before = resource.bytes;
+        Value copy(root, &resource);
+        REQUIRE(resource.bytes > before);
+        REQUIRE(copy["list"][1].getResource() == &resource);
+
+        StreamParser stream(copy);
+        stream.feed(json);
+        stream.finish();
+        REQUIRE(copy["list"][1].getResource() == &resource);
+    }
+    // Nodes of non monotonic resources are freed one by one
+    REQUIRE(resource.bytes == 0);
+
+#if defined(ELSON_HAS_PMR)
+    char buffer[4096];
+    std::pmr::monotonic_buffer_resource monotonic(buffer, sizeof(buffer));
+    PmrResource pmr(&monotonic, true);
+    Value root(&pmr);
+    FastParser fast;
+    fast.parse(root, json);
+    REQUIRE(root["name"].as<std::string>()
+        == "a string that is too long to be stored inline");
+#endif
+}
+
+TEST_CASE("memory/keys", "Interned object keys") {
+    // Short keys stay inline, long ones are shared
+    CountingResource resource;
+    {
+        KeyTable table(&resource);
+        Key a = table.intern("a long key of a record");
+        Key b = table.intern(std::string("a long key of a record"));
+        Key c = table.intern("another long key of a record");
+        Key d = table.intern("short", 5);
+        REQUIRE(a.isInterned());
+        REQUIRE(a.data() == b.data());
+        REQUIRE(a != c);
+        REQUIRE(!d.isInterned());
+        REQUIRE(table.size() == 2);
+
+        // Copies own their characters
+        Key copy = a;
+        REQUIRE(!copy.isInterned());
+        REQUIRE(copy == a);
+        REQUIRE(copy.data() != a.data());
+
+        for (int index = 0; index < 1000; index++) {
+            std::ostringstream key;
+            key << "a long generated key " << index;
+            table.intern(key.str());
+        }
+        REQUIRE(table.size() == 1002);
+        REQUIRE(table.intern("a long key of a record").data() == a.data());
+    }
+    REQUIRE(resource.bytes == 0);
+
+    std::string json = "[";
+    for (int index = 0; index < 100; index++) {
+        json += index ? ", " : "";
+        json += "{\"identifier of the record\": 1, \"name of the record\": \"x\", "
+            "\"id\": 2, \"nested record\": {\"identifier of the record\": 3}}";
+    }
+    json += "]";
+
+    Parser parser;
+    FastParser fast;
+    Document interned;
+    Document plain(64 * 1024, false);
+    REQUIRE(plain.getKeyTable() == 0);
+    parser.parse(plain, json);
+    for (int parse = 0; parse < 2; parse++) {
+        if (parse == 0) {
+            parser.parse(interned, json);
+        } else {
+            fast.parse(interned, json);
+        }
+        REQUIRE(interned.getKeyTable()->size() == 2);
+
+        Array& records = interned.getRoot().asMutable<Array>();
+        const Object& first = records[0].asMutable<Object>();
+        const Object& last = records[99].asMutable<Object>();
+        REQUIRE(first.find("name of the record", 18)->first.isInterned());
+        for (Object::const_iterator a = first.begin(), b = last.begin();
+             a != first.end(); ++a, ++b) {
+            REQUIRE(a->first.isInterned() == (a->first.length() > 14));
+            if (a->first.isInterned()) {
+                REQUIRE(a->first.data() == b->first.data());
+            }
+        }
+        REQUIRE(interned.getRoot()[99]["nested record"]
+            ["identifier of the record"].as<int>() == 3);
+        REQUIRE(interned.getArena().used() < plain.getArena().used());
+    }
+
+    // Values copied out of the document own their keys
+    Value copy = interned.getRoot()[0];
+    interned.reset();
+    REQUIRE(interned.getKeyTable()->size() == 0);
+    REQUIRE(copy["name of the record"].as<std::string>() == "x");
+
+    Printer printer;
+    Value expected;
+    parser.parse(expected, json);
+    parser.parse(interned, json);
+    REQUIRE(printer.print(interned.getRoot()) == printer.print(expected));
+}
+
 int main (int argc, char* const argv[]) {
      exit(Catch::Main( argc, argv ));
      return 0;